@@ -146,3 +146,309 @@ int main() {
 // 注意：千萬不要回傳區域變數 (Local Variable) 的參考。
 // 因為函式結束後，區域變數就被銷毀了，你的參考會變成「懸空參考 (Dangling Reference)」
 // 這跟 C 語言「回傳區域變數的指標」是一樣嚴重的錯誤。
+
+
+// 補充 : 一百萬個 player 一起回血 (AoS vs SoA 與 SIMD)
+// 上面的 player 是 {hp, mp, exp} 三個 int 綁在一起，一個 struct 一個 struct 排在記憶體裡：
+// [hp mp exp][hp mp exp][hp mp exp]...  這叫 AoS (Array of Structs，結構的陣列)。
+// 如果每一幀 (frame) 只想做「所有人 hp 回 5 點」，CPU 從記憶體搬進來的資料有 2/3 是用不到的 mp 和 exp。
+// 換個排法：把同一個欄位排在一起
+// hp:  [hp hp hp hp ...]
+// mp:  [mp mp mp mp ...]
+// exp: [exp exp exp ...]  這叫 SoA (Struct of Arrays，陣列的結構)，也就是「欄式 (columnar)」儲存。
+// 好處：
+// a. 只碰需要的欄位，記憶體頻寬一點都不浪費。
+// b. 同一個欄位連續排好，剛好可以用 SIMD (一個指令同時算好幾個數字)。
+//    AVX2 的暫存器有 256 bits = 8 個 int32，一個指令就幫 8 個玩家回血。
+
+// 程式碼範例：欄式玩家表 + AVX2 核心
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <new>        // align_val_t
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define HAVE_AVX2_KERNELS 1
+#endif
+using namespace std;
+struct player {
+    int hp;
+    int mp;
+    int exp;
+};
+
+// 對齊 64 bytes (一條快取線) 的 int32 欄位
+class column {
+private:
+    int32_t *ptr = nullptr;
+    size_t n = 0;
+public:
+    explicit column(size_t count = 0) : n(count) {
+        if (n != 0) ptr = static_cast<int32_t*>(::operator new(n * sizeof(int32_t), align_val_t(64)));
+    }
+    ~column() {
+        if (ptr != nullptr) ::operator delete(ptr, align_val_t(64));
+    }
+    column(column &&o) noexcept : ptr(o.ptr), n(o.n) {
+        o.ptr = nullptr;
+        o.n = 0;
+    }
+    column(const column&) = delete;
+    column& operator=(const column&) = delete;
+    int32_t *data() { return ptr; }
+    const int32_t *data() const { return ptr; }
+    int32_t &operator[](size_t i) { return ptr[i]; }
+    int32_t operator[](size_t i) const { return ptr[i]; }
+};
+
+// ---- 一般迴圈版本 (編譯器自己決定要不要向量化) ----
+// 回復量 add >= 0、上限 cap >= 0。不能寫 min(v + add, cap)：v 接近 INT32_MAX 時 v + add 會溢位 (未定義行為)，
+// 所以先跟 cap - add 取小再加，結果一樣是 min(v + add, cap)，但中間值永遠不會超過 cap
+void regen_scalar(int32_t *v, size_t n, int32_t add, int32_t cap) {
+    for (size_t i = 0; i < n; i++) v[i] = min(v[i], cap - add) + add;
+}
+// 負的傷害當成 0 (扣血不能變成補血)，負的 hp 當成 0 (已經倒下)。兩邊都先拉到 >= 0，
+// 相減的結果一定落在 [-INT32_MAX, INT32_MAX]，不會溢位，AVX2 版本也照同樣的順序算
+void damage_scalar(int32_t *hp, const int32_t *dmg, size_t n) {
+    for (size_t i = 0; i < n; i++) hp[i] = max(max(hp[i], 0) - max(dmg[i], 0), 0);
+}
+size_t count_below_scalar(const int32_t *v, size_t n, int32_t x) {
+    size_t c = 0;
+    for (size_t i = 0; i < n; i++) c += v[i] < x;
+    return c;
+}
+
+// ---- AVX2 版本：一次處理 8 個玩家，剩下不滿 8 個的交給一般迴圈 ----
+#ifdef HAVE_AVX2_KERNELS
+__attribute__((target("avx2")))
+void regen_avx2(int32_t *v, size_t n, int32_t add, int32_t cap) {
+    __m256i a = _mm256_set1_epi32(add), c = _mm256_set1_epi32(cap - add);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_load_si256(reinterpret_cast<const __m256i*>(v + i));
+        x = _mm256_add_epi32(_mm256_min_epi32(x, c), a);   // 跟一般版本一樣先取小再加，不會繞回負數
+        _mm256_store_si256(reinterpret_cast<__m256i*>(v + i), x);
+    }
+    regen_scalar(v + i, n - i, add, cap);
+}
+__attribute__((target("avx2")))
+void damage_avx2(int32_t *hp, const int32_t *dmg, size_t n) {
+    __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i h = _mm256_load_si256(reinterpret_cast<const __m256i*>(hp + i));
+        __m256i d = _mm256_load_si256(reinterpret_cast<const __m256i*>(dmg + i));
+        h = _mm256_max_epi32(h, zero);
+        d = _mm256_max_epi32(d, zero);
+        h = _mm256_max_epi32(_mm256_sub_epi32(h, d), zero);  // 扣血，最低到 0
+        _mm256_store_si256(reinterpret_cast<__m256i*>(hp + i), h);
+    }
+    damage_scalar(hp + i, dmg + i, n - i);
+}
+__attribute__((target("avx2,popcnt")))
+size_t count_below_avx2(const int32_t *v, size_t n, int32_t x) {
+    __m256i t = _mm256_set1_epi32(x);
+    size_t c = 0, i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i h = _mm256_load_si256(reinterpret_cast<const __m256i*>(v + i));
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(t, h)));  // 8 個比較結果濃縮成 8 bits
+        c += __builtin_popcount(mask);
+    }
+    return c + count_below_scalar(v + i, n - i, x);
+}
+__attribute__((target("avx2")))
+void select_below_avx2(const int32_t *v, size_t n, int32_t x, vector<uint32_t> &out) {
+    __m256i t = _mm256_set1_epi32(x);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i h = _mm256_load_si256(reinterpret_cast<const __m256i*>(v + i));
+        unsigned mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(t, h)));
+        while (mask != 0) {              // 大部分的組別 mask 是 0，直接跳過
+            out.push_back(i + __builtin_ctz(mask));
+            mask &= mask - 1;
+        }
+    }
+    for (; i < n; i++) if (v[i] < x) out.push_back(i);
+}
+#endif
+
+class player_table {
+private:
+    size_t n;
+    column hp, mp, exp;
+    bool simd;
+public:
+    explicit player_table(size_t count) : n(count), hp(count), mp(count), exp(count) {
+#ifdef HAVE_AVX2_KERNELS
+        simd = __builtin_cpu_supports("avx2");   // 執行時才檢查這台 CPU 有沒有 AVX2
+#else
+        simd = false;
+#endif
+    }
+    // 跟原本的 AoS player 互相轉換
+    static player_table from_aos(const vector<player> &ps) {
+        player_table t(ps.size());
+        for (size_t i = 0; i < ps.size(); i++) {
+            t.hp[i] = ps[i].hp;
+            t.mp[i] = ps[i].mp;
+            t.exp[i] = ps[i].exp;
+        }
+        return t;
+    }
+    void to_aos(vector<player> &ps) const {
+        ps.resize(n);
+        for (size_t i = 0; i < n; i++) ps[i] = {hp[i], mp[i], exp[i]};
+    }
+    size_t size() const { return n; }
+    player get(size_t i) const { return {hp[i], mp[i], exp[i]}; }
+    void use_simd(bool on) {
+#ifdef HAVE_AVX2_KERNELS
+        simd = on && __builtin_cpu_supports("avx2");
+#else
+        simd = false;
+        (void)on;
+#endif
+    }
+    bool using_simd() const { return simd; }
+
+    // 回血回魔：加上去，但不能超過上限
+    void regen(int32_t hp_add, int32_t hp_max, int32_t mp_add, int32_t mp_max) {
+#ifdef HAVE_AVX2_KERNELS
+        if (simd) {
+            regen_avx2(hp.data(), n, hp_add, hp_max);
+            regen_avx2(mp.data(), n, mp_add, mp_max);
+            return;
+        }
+#endif
+        regen_scalar(hp.data(), n, hp_add, hp_max);
+        regen_scalar(mp.data(), n, mp_add, mp_max);
+    }
+    // 每個人受到的傷害不一樣 (dmg 也是一條對齊的欄位)，hp 最低到 0
+    void damage(const column &dmg) {
+#ifdef HAVE_AVX2_KERNELS
+        if (simd) return damage_avx2(hp.data(), dmg.data(), n);
+#endif
+        damage_scalar(hp.data(), dmg.data(), n);
+    }
+    // 經驗值沒有上限，只要防止 int 溢位 (amount 可以是負的，例如死亡懲罰)：用 64 位元加完再夾回 int32 的範圍
+    void gain_exp(int32_t amount) {
+        for (size_t i = 0; i < n; i++) exp[i] = (int32_t)clamp<int64_t>((int64_t)exp[i] + amount, INT32_MIN, INT32_MAX);
+    }
+    // 查詢「hp 低於 x 的玩家」
+    size_t count_hp_below(int32_t x) const {
+#ifdef HAVE_AVX2_KERNELS
+        if (simd) return count_below_avx2(hp.data(), n, x);
+#endif
+        return count_below_scalar(hp.data(), n, x);
+    }
+    void select_hp_below(int32_t x, vector<uint32_t> &out) const {
+        out.clear();
+#ifdef HAVE_AVX2_KERNELS
+        if (simd) return select_below_avx2(hp.data(), n, x, out);
+#endif
+        for (size_t i = 0; i < n; i++) if (hp[i] < x) out.push_back(i);
+    }
+};
+
+// AoS 的對照組：一個 struct 一個 struct 算
+void regen_aos(vector<player> &ps, int hp_add, int hp_max, int mp_add, int mp_max) {
+    for (player &p : ps) {
+        p.hp = min(p.hp, hp_max - hp_add) + hp_add;   // 和 regen_scalar 一樣先取小再加，避免溢位
+        p.mp = min(p.mp, mp_max - mp_add) + mp_add;
+    }
+}
+size_t count_below_aos(const vector<player> &ps, int x) {
+    return count_if(ps.begin(), ps.end(), [x](const player &p) { return p.hp < x; });
+}
+
+// 正確性：同樣的操作分別套在 AoS 和 SoA (一般 / AVX2) 上，結果要一模一樣
+// 玩家數故意不是 8 的倍數，順便檢查尾巴那幾個
+bool verify() {
+    const size_t n = 1003;
+    vector<player> ref(n);
+    for (size_t i = 0; i < n; i++) ref[i] = {(int)(i * 37 % 1000), (int)(i % 500), (int)i};
+    player_table plain = player_table::from_aos(ref), fast = player_table::from_aos(ref);
+    plain.use_simd(false);
+    fast.use_simd(true);
+    column dmg(n);
+    for (size_t i = 0; i < n; i++) dmg[i] = (int32_t)(i % 300);
+
+    regen_aos(ref, 50, 1000, 30, 500);
+    for (size_t i = 0; i < n; i++) ref[i].hp = max(max(ref[i].hp, 0) - max(dmg[i], 0), 0);
+    for (size_t i = 0; i < n; i++) ref[i].exp += 10;
+    for (player_table *t : {&plain, &fast}) {
+        t->regen(50, 1000, 30, 500);
+        t->damage(dmg);
+        t->gain_exp(10);
+    }
+    vector<player> a, b;
+    plain.to_aos(a);
+    fast.to_aos(b);
+    bool ok = true;
+    for (size_t i = 0; i < n; i++) {
+        ok = ok && a[i].hp == ref[i].hp && a[i].mp == ref[i].mp && a[i].exp == ref[i].exp;
+        ok = ok && b[i].hp == ref[i].hp && b[i].mp == ref[i].mp && b[i].exp == ref[i].exp;
+    }
+    vector<uint32_t> low;
+    fast.select_hp_below(100, low);
+    size_t expect = count_below_aos(ref, 100);
+    ok = ok && plain.count_hp_below(100) == expect && fast.count_hp_below(100) == expect && low.size() == expect;
+    for (uint32_t i : low) ok = ok && ref[i].hp < 100;
+    return ok;
+}
+
+template <typename F>
+double time_ms(F f, int reps = 5) {
+    auto t0 = chrono::steady_clock::now();
+    for (int r = 0; r < reps; r++) f();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count() / reps;
+}
+
+int main(int argc, char **argv) {
+    // 用法: ./a.out [最多幾個玩家]，例如 ./a.out 100000000 (一億個玩家大約要 3GB 記憶體)
+    size_t max_n = argc > 1 ? stoull(argv[1]) : 10000000;
+    cout << "正確性檢查: " << (verify() ? "OK" : "失敗!") << (player_table(8).using_simd() ? "" : " (這台 CPU 沒有 AVX2)") << endl;
+
+    for (size_t n = 1000000; n <= max_n; n *= 10) {
+        vector<player> aos(n);
+        for (size_t i = 0; i < n; i++) aos[i] = {(int)(i * 7919 % 1000), (int)(i % 500), 0};
+        player_table soa = player_table::from_aos(aos);
+        column dmg(n);
+        for (size_t i = 0; i < n; i++) dmg[i] = (int32_t)(i % 13);
+
+        cout << "--- " << n << " 個玩家 (每個數字是毫秒) ---" << endl;
+        // 每次查不同的門檻 (100, 101, ...) 並把結果加總，編譯器就不能偷懶只算一次
+        size_t f1 = 0, f2 = 0, f3 = 0;
+        int q1 = 100, q2 = 100, q3 = 100;
+        cout << "查詢 hp<100  AoS: " << time_ms([&] { f1 += count_below_aos(aos, q1++); });
+        soa.use_simd(false);
+        cout << " | SoA 一般: " << time_ms([&] { f2 += soa.count_hp_below(q2++); });
+        soa.use_simd(true);
+        cout << " | SoA AVX2: " << time_ms([&] { f3 += soa.count_hp_below(q3++); }) << " (找到 " << f3 / 5 << " 個左右)" << endl;
+        if (f1 != f2 || f2 != f3) cout << "三種做法的答案不一樣!" << endl;
+
+        cout << "回血  AoS: " << time_ms([&] { regen_aos(aos, 5, 1000, 3, 500); });
+        soa.use_simd(false);
+        cout << " | SoA 一般: " << time_ms([&] { soa.regen(5, 1000, 3, 500); });
+        soa.use_simd(true);
+        cout << " | SoA AVX2: " << time_ms([&] { soa.regen(5, 1000, 3, 500); }) << endl;
+
+        soa.use_simd(false);
+        cout << "扣血  SoA 一般: " << time_ms([&] { soa.damage(dmg); });
+        soa.use_simd(true);
+        cout << " | SoA AVX2: " << time_ms([&] { soa.damage(dmg); }) << endl;
+    }
+    return 0;
+}
+// 重點筆記：
+// 1. AoS 適合「一次處理一個物件的全部欄位」，SoA 適合「一次處理所有物件的同一個欄位」。
+// 2. 欄位對齊 64 bytes，SIMD 才能用對齊的 load/store，也不會跨快取線。
+// 3. target("avx2") + __builtin_cpu_supports：同一支程式在沒有 AVX2 的 CPU 上會自動走一般迴圈。
+// 4. 資料量大到超過快取之後，瓶頸會變成記憶體頻寬 —— 這時候「少搬資料」(SoA) 比「算得快」(SIMD) 更重要。
+// 5. 加上限的回復寫成 min(v, cap - add) + add，不是 min(v + add, cap)：前者中間值不會溢位，
+//    一般迴圈和 AVX2 版本 (_mm256_add_epi32 溢位會繞回負數) 在極端值也算出一樣的答案。
+//    扣血先把 hp、傷害都夾到 >= 0 再相減；經驗值用 64 位元算完再夾回來。有號整數溢位是未定義行為，不能只靠「通常不會發生」。
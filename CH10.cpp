@@ -80,3 +80,773 @@ int main() {
 // 用途：專門寫那些「很短、只用一次、不想特地命名」的小函式。
 // 搭配：通常跟 STL 演算法 (如 sort, for_each, count_if) 一起出現。
 // 捕捉：善用 [] 來使用外部變數，這是它最強的地方。
+
+
+// 補充 : 資料比記憶體還大怎麼辦？ (串流處理 + 外部排序)
+// 上面的範例都先把資料整個塞進 vector<int> 再 sort / count_if。
+// 但如果資料有好幾百 GB，電腦只有 16 GB 記憶體，vector 根本裝不下。
+// 解法是「串流 (streaming)」：一次只讀一塊 (chunk)，處理完就丟，記憶體用量是固定的。
+// 1. count_if 很簡單：每一塊各自 count_if，最後加起來就好。Lambda 完全不用改。
+// 2. sort 比較麻煩，要用「外部排序 (External Merge Sort)」：
+//    a. 產生順串 (run)：讀一塊 -> 用同一個 Lambda sort -> 寫回硬碟成一個排好的小檔案。
+//    b. k 路合併 (k-way merge)：同時打開所有小檔案，每次從「每個檔案目前最前面的數字」裡挑出冠軍寫出去。
+//       挑冠軍用「敗者樹 (Loser Tree)」：k 個選手的淘汰賽，每次只要重賽一條路徑，只比 log k 次。
+// 3. 雙緩衝 (double buffering)：CPU 在處理這一塊的時候，背景執行緒已經在讀下一塊 / 寫上一塊，
+//    硬碟和 CPU 同時在工作，整體速度才能逼近硬碟本身的頻寬。
+
+// 程式碼範例：
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <future>     // async：背景讀寫
+#include <chrono>
+#include <cstdio>     // FILE*, fread, fwrite
+#include <cstring>    // strerror
+#include <cerrno>
+#include <cstdint>
+#include <filesystem>
+using namespace std;
+namespace fs = std::filesystem;
+
+// 讀檔：一次讀一塊，同時在背景預讀下一塊
+// 背景的讀寫出錯時 (硬碟壞軌、硬碟滿了) 會 throw，例外存在 future 裡，等前景 get() 的時候再丟出來
+class chunk_reader {
+private:
+    FILE *f;
+    string name;
+    vector<int> cur, next;
+    future<size_t> pending;   // 背景正在讀的那一塊
+    void prefetch() {
+        pending = async(launch::async, [this] {
+            size_t n = fread(next.data(), sizeof(int), next.size(), f);
+            // 讀不滿一塊有兩種可能：檔案結束 (正常)，或是讀取錯誤 (不能當成檔案結束)
+            if (n < next.size() && ferror(f)) throw runtime_error("讀取 " + name + " 失敗: " + strerror(errno));
+            return n;
+        });
+    }
+public:
+    chunk_reader(const fs::path &path, size_t chunk_ints) : f(fopen(path.c_str(), "rb")), name(path.string()), cur(chunk_ints), next(chunk_ints) {
+        if (f == nullptr) throw runtime_error("打不開 " + name);
+        prefetch();
+    }
+    ~chunk_reader() {
+        if (pending.valid()) pending.wait();
+        fclose(f);
+    }
+    // 拿下一塊：等背景讀完，換手，然後立刻開始預讀再下一塊
+    // 拿到的這一塊在下次 read 之前都歸你，可以直接在上面改 (例如原地排序)
+    bool read(int *&data, size_t &n) {
+        n = pending.get();    // 背景讀取失敗的話，例外會從這裡丟出來
+        if (n == 0) return false;
+        cur.swap(next);
+        prefetch();
+        data = cur.data();
+        return true;
+    }
+};
+
+// 寫檔：填滿一塊就丟給背景寫，自己換另一塊繼續填
+// 寫完一定要呼叫 close()：解構子不能 throw，只有 close() 能告訴你「最後那幾塊到底有沒有寫進去」
+class chunk_writer {
+private:
+    FILE *f;
+    string name;
+    vector<int> cur, flushing;
+    size_t used = 0;
+    future<void> pending;
+    void flush() {
+        if (pending.valid()) pending.get();   // 上一塊寫失敗的話，例外會從這裡丟出來
+        cur.swap(flushing);
+        size_t n = used;
+        used = 0;
+        pending = async(launch::async, [this, n] {
+            if (fwrite(flushing.data(), sizeof(int), n, f) != n) throw runtime_error("寫入 " + name + " 失敗: " + strerror(errno));
+        });
+    }
+public:
+    chunk_writer(const fs::path &path, size_t chunk_ints) : f(fopen(path.c_str(), "wb")), name(path.string()), cur(chunk_ints), flushing(chunk_ints) {
+        if (f == nullptr) throw runtime_error("打不開 " + name);
+    }
+    // 把剩下的寫完、關檔，任何一步失敗都 throw (檔案不完整，不能當成成功)
+    void close() {
+        if (f == nullptr) return;
+        exception_ptr err;
+        try {
+            if (used > 0) flush();
+            if (pending.valid()) pending.get();
+            if (fflush(f) != 0) throw runtime_error("寫入 " + name + " 失敗: " + strerror(errno));
+        }
+        catch (...) {
+            err = current_exception();
+        }
+        if (fclose(f) != 0 && !err) err = make_exception_ptr(runtime_error("關閉 " + name + " 失敗: " + strerror(errno)));
+        f = nullptr;
+        if (err) rethrow_exception(err);
+    }
+    // 沒有 close() 就被解構 (通常是別的地方丟了例外)：只收拾，不再 throw
+    ~chunk_writer() {
+        if (f == nullptr) return;
+        if (pending.valid()) pending.wait();
+        fclose(f);
+    }
+    void push(int v) {
+        cur[used++] = v;
+        if (used == cur.size()) flush();
+    }
+    void write(const int *p, size_t n) {
+        for (size_t i = 0; i < n; i++) push(p[i]);
+    }
+};
+
+// 串流版 count_if：記憶體只用 2 塊 chunk，不管檔案多大
+template <typename Pred>
+size_t stream_count_if(const fs::path &path, size_t budget_bytes, Pred pred) {
+    chunk_reader in(path, budget_bytes / 2 / sizeof(int));
+    int *p;
+    size_t n, total = 0;
+    while (in.read(p, n)) total += count_if(p, p + n, pred);
+    return total;
+}
+
+// 敗者樹：k 個選手，tree[0] 是冠軍，tree[1..k-1] 記住每一場比賽的「輸家」
+// 冠軍換了新的數字之後，只要沿著它到根的那條路重賽一次
+template <typename Cmp>
+class loser_tree {
+private:
+    size_t k;
+    vector<size_t> tree;
+    vector<int> key;
+    vector<bool> alive;  // 這個選手 (順串) 還有沒有數字
+    Cmp cmp;
+    bool beats(size_t a, size_t b) const {   // a 贏 b？死掉的選手永遠輸
+        if (!alive[b]) return true;
+        if (!alive[a]) return false;
+        return !cmp(key[b], key[a]);           // 平手算 a 贏，合併結果才穩定
+    }
+public:
+    loser_tree(size_t n, Cmp c) : k(n), tree(n), key(n), alive(n, false), cmp(c) {}
+    void set(size_t i, int v) {
+        key[i] = v;
+        alive[i] = true;
+    }
+    void kill(size_t i) { alive[i] = false; }
+    // 第一次比賽：由下往上打完整個淘汰賽 (葉子放在 k..2k-1)
+    void build() {
+        vector<size_t> win(2 * k);
+        for (size_t i = 0; i < k; i++) win[k + i] = i;
+        for (size_t node = k - 1; node >= 1; node--) {
+            size_t a = win[2 * node], b = win[2 * node + 1];
+            win[node] = beats(a, b) ? a : b;
+            tree[node] = beats(a, b) ? b : a;
+        }
+        tree[0] = k == 1 ? 0 : win[1];
+    }
+    size_t winner() const { return tree[0]; }
+    bool empty() const { return !alive[tree[0]]; }
+    int top() const { return key[tree[0]]; }
+    // 冠軍的值換掉 (或死掉) 之後重賽
+    void replay() {
+        size_t w = tree[0];
+        for (size_t node = (k + w) / 2; node >= 1; node /= 2) {
+            if (beats(tree[node], w)) swap(tree[node], w);
+        }
+        tree[0] = w;
+    }
+};
+
+// 把幾個排好的順串合併成一個
+template <typename Cmp>
+void merge_runs(const vector<fs::path> &runs, const fs::path &out, size_t budget_bytes, Cmp cmp) {
+    // 每個輸入 2 塊 + 輸出 2 塊，平分記憶體預算
+    size_t chunk = max<size_t>(budget_bytes / sizeof(int) / (2 * runs.size() + 2), 1024);
+    vector<unique_ptr<chunk_reader>> in;
+    vector<int*> ptr(runs.size());
+    vector<size_t> left(runs.size(), 0);
+    loser_tree<Cmp> lt(runs.size(), cmp);
+    for (size_t i = 0; i < runs.size(); i++) {
+        in.push_back(make_unique<chunk_reader>(runs[i], chunk));
+        if (in[i]->read(ptr[i], left[i])) lt.set(i, *ptr[i]);
+    }
+    lt.build();
+    chunk_writer w(out, chunk);
+    while (!lt.empty()) {
+        size_t i = lt.winner();
+        w.push(lt.top());
+        ptr[i]++;
+        if (--left[i] == 0 && !in[i]->read(ptr[i], left[i])) lt.kill(i);
+        else lt.set(i, *ptr[i]);
+        lt.replay();
+    }
+    w.close();
+}
+
+// 外部排序：記憶體最多用 budget_bytes，comparator 就是 CH10 那種 Lambda
+template <typename Cmp>
+void external_sort(const fs::path &in, const fs::path &out, size_t budget_bytes, Cmp cmp, const fs::path &tmpdir) {
+    fs::create_directories(tmpdir);
+    // 1. 產生順串：一塊在排序的同時，另一塊在背景讀 (所以每塊是預算的一半)
+    vector<fs::path> runs;
+    {
+        chunk_reader reader(in, budget_bytes / 2 / sizeof(int));
+        int *p;
+        size_t n;
+        while (reader.read(p, n)) {
+            sort(p, p + n, cmp);   // 直接在讀進來的那一塊上排序，不多複製一份
+            runs.push_back(tmpdir / ("run" + to_string(runs.size())));
+            chunk_writer w(runs.back(), 1 << 16);
+            w.write(p, n);
+            w.close();
+        }
+    }
+    if (runs.empty()) {
+        chunk_writer(out, 1).close();
+        return;
+    }
+    // 2. 合併：順串太多時，一次最多合併 fan_in 個 (每塊至少 64K 個 int)，分好幾輪
+    size_t fan_in = max<size_t>(budget_bytes / sizeof(int) / (1 << 16) / 2, 2);
+    size_t generation = 0;
+    while (runs.size() > 1) {
+        vector<fs::path> merged;
+        for (size_t i = 0; i < runs.size(); i += fan_in) {
+            vector<fs::path> group(runs.begin() + i, runs.begin() + min(i + fan_in, runs.size()));
+            fs::path dst = tmpdir / ("merge" + to_string(generation) + "_" + to_string(merged.size()));
+            merge_runs(group, dst, budget_bytes, cmp);
+            for (auto &r : group) fs::remove(r);
+            merged.push_back(dst);
+        }
+        runs.swap(merged);
+        generation++;
+    }
+    fs::rename(runs[0], out);
+}
+
+double seconds_since(chrono::steady_clock::time_point t0) {
+    return chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char **argv) {
+    // 用法: ./a.out [整數個數] [記憶體預算 MB]，例如 ./a.out 1000000000 1024
+    size_t n = argc > 1 ? stoull(argv[1]) : 20000000;
+    size_t budget = (argc > 2 ? stoull(argv[2]) : 16) << 20;
+    fs::path dir = fs::temp_directory_path() / "stream_demo";
+    fs::create_directories(dir);
+    fs::path input = dir / "input.bin", output = dir / "sorted.bin";
+
+    // 準備一個大檔案 (一般情況下它本來就在硬碟上)
+    long long sum_in = 0;
+    {
+        chunk_writer w(input, 1 << 20);
+        uint32_t x = 2463534242u;
+        for (size_t i = 0; i < n; i++) {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            int v = (int)(x % 1000000);
+            sum_in += v;
+            w.push(v);
+        }
+        w.close();
+    }
+    double mb = n * sizeof(int) / 1048576.0;
+    cout << "檔案大小 " << mb << " MB, 記憶體預算 " << (budget >> 20) << " MB" << endl;
+
+    // 0. 純讀檔速度 (天花板)
+    auto t0 = chrono::steady_clock::now();
+    stream_count_if(input, budget, [](int) { return false; });
+    cout << "單純讀一遍: " << mb / seconds_since(t0) << " MB/s" << endl;
+
+    // 1. 串流 count_if：跟 CH10 一模一樣的 Lambda
+    int threshold = 500000;
+    t0 = chrono::steady_clock::now();
+    size_t count = stream_count_if(input, budget, [threshold](int v) { return v > threshold; });
+    cout << "大於 " << threshold << " 的數字有 " << count << " 個 (" << mb / seconds_since(t0) << " MB/s)" << endl;
+
+    // 2. 外部排序：也是 CH10 那個「由大排到小」的 Lambda
+    auto desc = [](int a, int b) { return a > b; };
+    t0 = chrono::steady_clock::now();
+    external_sort(input, output, budget, desc, dir / "tmp");
+    double sec = seconds_since(t0);
+    cout << "外部排序花了 " << sec << " 秒 (" << mb / sec << " MB/s)" << endl;
+
+    // 驗證：順序對、個數對、總和對
+    chunk_reader check(output, 1 << 20);
+    int *p;
+    size_t got, total = 0;
+    long long sum_out = 0;
+    int prev = INT32_MAX;
+    bool ok = true;
+    while (check.read(p, got)) {
+        for (size_t i = 0; i < got; i++) {
+            ok = ok && !desc(p[i], prev);
+            prev = p[i];
+            sum_out += p[i];
+        }
+        total += got;
+    }
+    cout << (ok && total == n && sum_out == sum_in ? "排序結果正確" : "排序結果錯誤!") << endl;
+    fs::remove_all(dir);
+    return 0;
+}
+// 重點筆記：
+// 1. 記憶體用量由 budget 決定，跟檔案大小無關：這就是串流處理的精神。
+// 2. Lambda 是「可以搬來搬去的邏輯」：記憶體內的 sort 和硬碟上的外部排序用的是同一個比較函式。
+// 3. 敗者樹每輸出一個數字只要比 log k 次，k 個順串一次合併完，不必兩兩合併好幾輪。
+// 4. 雙緩衝讓讀、算、寫同時進行；count_if 這種輕量的工作會直接跑到硬碟頻寬的上限，
+//    排序則是 CPU 比較重 (光是 sort 本身就要時間)，多核心時可以讓每個順串用不同的執行緒排序。
+// 5. 背景執行緒的 I/O 錯誤要用 throw 帶回前景 (future::get 會重新丟出來)；
+//    寫檔最後一定要檢查 fflush / fclose，不然硬碟滿了也會「排序成功」，結果檔案少了一截。
+
+
+// 補充 : 比較函式很貴的時候 (每個 key 只算一次：sort_by_key)
+// 最上面的 sort 範例，Lambda 只是 a > b，很便宜。
+// 但如果比較的東西要「算」出來，例如依照角色的戰力分數排序：
+//     sort(v.begin(), v.end(), [](auto &a, auto &b) { return score(a) < score(b); });
+// sort 大約會呼叫比較函式 n log n 次，每次算兩個分數，
+// 1000 萬個角色就要算超過 9 億次 score()，真正花時間的是算分數，不是排序本身。
+// 解法 (Schwartzian transform / decorate-sort-undecorate)：
+// 1. 每個元素只算一次 key，和原本的位置 (index) 一起放進一個緊密的陣列 {key, index}。
+// 2. 排序這個小陣列：
+//    - key 是數字 (int、double...)：用基數排序 (radix sort)，完全不用比較，O(n)。
+//    - key 是字串：把「前 8 個位元組」打包成整數先做基數排序，前綴相同的那一小段才用 std::sort 比完整字串。
+//    - 其他型別：用 std::sort 比較快取好的 key。
+// 3. 照排好的 index，把原本的物件「就地」搬到正確位置 (每個物件只搬一次)。
+// 另外一個好處：排序時搬動的是 12~16 bytes 的 {key, index}，而不是整個物件。
+
+// 程式碼範例：
+#include <iostream>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <algorithm>
+#include <type_traits>
+#include <functional>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+using namespace std;
+
+// 把數字轉成「無號整數，而且大小順序不變」，基數排序才能一個位元組一個位元組地排
+template <typename K>
+auto radix_bits(K k) {
+    if constexpr (is_floating_point_v<K>) {
+        using U = conditional_t<sizeof(K) == 8, uint64_t, uint32_t>;
+        U u;
+        memcpy(&u, &k, sizeof(k));
+        const U sign = U(1) << (sizeof(U) * 8 - 1);
+        return (u & sign) ? ~u : (u | sign);      // 負數整個翻轉，正數只翻符號位
+    }
+    else {
+        using U = make_unsigned_t<conditional_t<is_same_v<K, bool>, unsigned char, K>>;
+        U u = (U)k;
+        if constexpr (is_signed_v<K>) u ^= U(1) << (sizeof(U) * 8 - 1);
+        return u;
+    }
+}
+
+template <typename U>
+struct radix_entry {
+    U key;
+    uint32_t index;
+};
+
+// LSD 基數排序：從最低的位元組排到最高的位元組，每一趟都是穩定的
+template <typename U>
+void radix_sort(vector<radix_entry<U>> &a) {
+    const int passes = sizeof(U);
+    vector<size_t> count(passes * 256, 0);
+    for (auto &e : a)                             // 一次掃描就把每一趟的直方圖都算好
+        for (int p = 0; p < passes; p++) count[p * 256 + ((e.key >> (p * 8)) & 0xff)]++;
+    vector<radix_entry<U>> tmp(a.size());
+    for (int p = 0; p < passes; p++) {
+        size_t *c = &count[p * 256];
+        if (*max_element(c, c + 256) == a.size()) continue;  // 這個位元組大家都一樣，跳過
+        size_t sum = 0;
+        for (int b = 0; b < 256; b++) {
+            size_t t = c[b];
+            c[b] = sum;
+            sum += t;
+        }
+        for (auto &e : a) tmp[c[(e.key >> (p * 8)) & 0xff]++] = e;
+        a.swap(tmp);
+    }
+}
+
+// 字串的前 8 個位元組用 big-endian 打包成整數：整數大小順序 = 字串字典順序
+template <typename K>
+uint64_t key_prefix(const K &k) {
+    if constexpr (is_convertible_v<const K&, string_view>) {
+        string_view s = k;
+        uint64_t p = 0;
+        for (size_t i = 0; i < 8; i++) p = (p << 8) | (i < s.size() ? (unsigned char)s[i] : 0);
+        return p;
+    }
+    else {
+        return 0;  // 其他型別沒有前綴可以用，全部交給完整比較
+    }
+}
+
+// 照 order 就地重排：order[i] = 「排好之後第 i 個位置」應該放原本的第幾個
+// 沿著環 (cycle) 走，每個物件只被 move 一次
+template <typename It>
+void apply_permutation(It first, vector<uint32_t> &order) {
+    using T = typename iterator_traits<It>::value_type;
+    for (uint32_t i = 0; i < order.size(); i++) {
+        if (order[i] == i) continue;
+        T tmp = move(first[i]);
+        uint32_t j = i;
+        while (order[j] != i) {
+            first[j] = move(first[order[j]]);
+            uint32_t next = order[j];
+            order[j] = j;                         // 標記已經放好了
+            j = next;
+        }
+        first[j] = move(tmp);
+        order[j] = j;
+    }
+}
+
+// 依照 key(元素) 由小到大排序 (穩定排序：key 一樣時保持原本的先後)
+template <typename It, typename KeyFn>
+void sort_by_key(It first, It last, KeyFn key) {
+    const size_t n = last - first;
+    using R = invoke_result_t<KeyFn&, decltype(*first)>;
+    using K = remove_cvref_t<R>;
+    vector<uint32_t> order(n);
+    if constexpr (is_arithmetic_v<K>) {
+        using U = decltype(radix_bits(K{}));
+        vector<radix_entry<U>> e(n);
+        for (uint32_t i = 0; i < n; i++) e[i] = {radix_bits<K>(key(first[i])), i};
+        radix_sort(e);
+        for (size_t i = 0; i < n; i++) order[i] = e[i].index;
+    }
+    else {
+        // key 如果是回傳成員的參考 (例如 name)，只記指標，不複製字串
+        using Stored = conditional_t<is_lvalue_reference_v<R>, const K*, K>;
+        vector<Stored> keys;
+        keys.reserve(n);
+        auto full = [&](uint32_t i) -> const K& {
+            if constexpr (is_lvalue_reference_v<R>) return *keys[i];
+            else return keys[i];
+        };
+        vector<radix_entry<uint64_t>> e(n);
+        for (uint32_t i = 0; i < n; i++) {
+            if constexpr (is_lvalue_reference_v<R>) keys.push_back(&key(first[i]));
+            else keys.push_back(key(first[i]));
+            e[i] = {key_prefix(full(i)), i};
+        }
+        auto less = [&](const radix_entry<uint64_t> &a, const radix_entry<uint64_t> &b) {
+            if (a.key != b.key) return a.key < b.key;
+            if (full(a.index) < full(b.index)) return true;
+            if (full(b.index) < full(a.index)) return false;
+            return a.index < b.index;                            // key 一樣就照原本順序 (穩定)
+        };
+        if constexpr (is_convertible_v<const K&, string_view>) {
+            // 字串：先用基數排序排好前綴，只有「前綴一樣」的那一小段才需要真正比較字串
+            radix_sort(e);
+            for (size_t i = 0, j; i < n; i = j) {
+                for (j = i + 1; j < n && e[j].key == e[i].key; j++) {}
+                if (j - i > 1) sort(e.begin() + i, e.begin() + j, less);
+            }
+        }
+        else {
+            sort(e.begin(), e.end(), less);
+        }
+        for (size_t i = 0; i < n; i++) order[i] = e[i].index;
+    }
+    apply_permutation(first, order);
+}
+
+class character {
+public:
+    string name;
+    int level;
+    int hp;
+    double atk;
+};
+
+// 「算出來」的戰力分數：每呼叫一次都要做幾次浮點運算
+double score(const character &c) {
+    return c.level * 12.5 + sqrt((double)c.hp) * 3.0 + log1p(c.atk) * 40.0 + pow(c.atk, 0.3);
+}
+
+template <typename F>
+double timed(F f) {
+    auto t0 = chrono::steady_clock::now();
+    f();
+    return chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char **argv) {
+    // 用法: ./a.out [角色數量]，預設 1000 萬
+    size_t n = argc > 1 ? stoul(argv[1]) : 10000000;
+    mt19937_64 rng(42);
+    vector<character> base(n);
+    for (auto &c : base) {
+        int len = 6 + rng() % 7;
+        for (int i = 0; i < len; i++) c.name += char('a' + rng() % 26);
+        c.level = rng() % 100;
+        c.hp = rng() % 10000;
+        c.atk = (rng() % 100000) / 10.0;
+    }
+    cout << "角色數量: " << n << endl;
+
+    // 1. 數字 key：依照算出來的戰力分數
+    {
+        vector<character> a = base, b = base;
+        double t1 = timed([&] {
+            sort(a.begin(), a.end(), [](const character &x, const character &y) { return score(x) < score(y); });
+        });
+        double t2 = timed([&] { sort_by_key(b.begin(), b.end(), [](const character &c) { return score(c); }); });
+        bool same = true;
+        for (size_t i = 0; i < n; i++) same = same && score(a[i]) == score(b[i]);
+        cout << "戰力分數  sort+Lambda: " << t1 << " 秒 | sort_by_key (基數排序): " << t2 << " 秒 | "
+             << (same ? "結果一致" : "結果不一致!") << endl;
+    }
+    // 2. 字串 key：依照名字
+    {
+        vector<character> a = base, b = base;
+        double t1 = timed([&] {
+            sort(a.begin(), a.end(), [](const character &x, const character &y) { return x.name < y.name; });
+        });
+        double t2 = timed([&] {
+            sort_by_key(b.begin(), b.end(), [](const character &c) -> const string& { return c.name; });
+        });
+        bool same = true;
+        for (size_t i = 0; i < n; i++) same = same && a[i].name == b[i].name;
+        cout << "名字      sort+Lambda: " << t1 << " 秒 | sort_by_key (前綴+索引): " << t2 << " 秒 | "
+             << (same ? "結果一致" : "結果不一致!") << endl;
+    }
+    // 3. 穩定性：同一個等級的角色，維持原本的先後順序
+    {
+        vector<character> small(base.begin(), base.begin() + min<size_t>(n, 1000));
+        vector<character> expect = small;
+        stable_sort(expect.begin(), expect.end(), [](const character &x, const character &y) { return x.level < y.level; });
+        sort_by_key(small.begin(), small.end(), [](const character &c) { return c.level; });
+        bool same = true;
+        for (size_t i = 0; i < small.size(); i++) same = same && small[i].name == expect[i].name;
+        cout << "依等級排序和 stable_sort " << (same ? "完全相同 (穩定)" : "不同!") << endl;
+    }
+    return 0;
+}
+// 重點筆記：
+// 1. 比較函式很貴時，瓶頸是「呼叫次數」(n log n)；先把 key 算好存起來，就只剩 n 次。
+// 2. 數字 key 可以用基數排序，完全不用比較；double / 有號整數要先轉成「順序不變」的無號整數。
+// 3. 字串 key 先用 8 個位元組的整數前綴做基數排序，大部分的元素根本不用比較字串本身。
+// 4. 排序的是小小的 {key, index}，最後才照順序把大物件各搬一次。
+
+
+// 補充 : 同一個問題一直問 (Fenwick 樹：增量統計與排行榜)
+// 上面的 count_if 範例每問一次「有幾個 > threshold」，就把整個 vector 從頭掃一遍 (O(n))。
+// 排行榜的畫面每秒都在問一樣的問題：「幾個人超過 5000 分？」「我排第幾名？」「前 10 名是誰？」，
+// 而分數同時也一直在變。每次都重掃 100 萬筆資料，CPU 全花在重複的工作上。
+// 換個角度：不要存「每個人幾分」的清單，而是存「每個分數有幾個人」，
+// 再用 Fenwick 樹 (Binary Indexed Tree) 維護前綴和：
+// 1. 新增 / 刪除 / 修改一個分數：O(log D) (D = 分數的範圍大小)。
+// 2. 「有幾個 > threshold」= 總數 - (<= threshold 的人數)：O(log D)。
+// 3. 名次：比我高分的人數 + 1：O(log D)。
+// 4. 第 k 高的分數：在樹上二分往下走：O(log D)；前 K 名就是重複 K 次 (相同分數一次拿完)。
+// 代價：分數必須是有範圍的整數 (這裡是 0 ~ 999999)；範圍很大的話要先做離散化 (壓縮成名次)。
+
+// 程式碼範例：
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <string>
+#include <stdexcept>
+#include <cstdint>
+using namespace std;
+
+class score_board {
+private:
+    vector<int64_t> tree;    // Fenwick 樹，tree[i] 管一段分數的人數 (索引從 1 開始)
+    vector<int> count_at;    // 每個分數剛好有幾人 (算前 K 名時用)
+    int64_t total = 0;
+    int64_t sum = 0;
+    int top_bit = 1;
+
+    // 分數超出範圍會寫到陣列外面，把樹弄壞：一律先檢查再動手
+    void check_score(int v) const {
+        if (v < 0 || v >= domain()) throw out_of_range("分數 " + to_string(v) + " 超出範圍");
+    }
+    void check_present(int v) const {
+        check_score(v);
+        if (count_at[v] == 0) throw invalid_argument("沒有人是 " + to_string(v) + " 分");
+    }
+    void add(int v, int delta) {
+        count_at[v] += delta;
+        total += delta;
+        sum += (int64_t)v * delta;
+        for (size_t i = v + 1; i < tree.size(); i += i & -i) tree[i] += delta;
+    }
+public:
+    explicit score_board(int domain) : tree(domain + 1, 0), count_at(domain, 0) {
+        while (top_bit * 2 <= domain) top_bit *= 2;
+    }
+    int domain() const { return (int)count_at.size(); }
+    void insert(int v) {
+        check_score(v);
+        add(v, +1);
+    }
+    void erase(int v) {
+        check_present(v);
+        add(v, -1);
+    }
+    void update(int old_v, int new_v) {
+        check_present(old_v);    // 兩個都檢查完才改，失敗時分數板完全不變
+        check_score(new_v);
+        add(old_v, -1);
+        add(new_v, +1);
+    }
+    // 分數 <= v 的人數 (v 可以是任何整數：太小就是 0 人，太大就是全部)
+    int64_t count_at_most(int v) const {
+        v = clamp(v, -1, domain() - 1);
+        int64_t s = 0;
+        for (size_t i = v + 1; i > 0; i -= i & -i) s += tree[i];
+        return s;
+    }
+    int64_t count_greater(int threshold) const { return total - count_at_most(threshold); }
+    // 分數 v 的名次 (比它高分的人數 + 1，同分同名次)
+    int64_t rank(int v) const { return count_greater(v) + 1; }
+    // 第 k 小的分數 (k 從 1 開始)：從最高位開始往下走，一路跳過「前綴和還不夠 k」的區段
+    int kth_smallest(int64_t k) const {
+        if (k < 1 || k > total) throw out_of_range("只有 " + to_string(total) + " 人，沒有第 " + to_string(k) + " 名");
+        size_t pos = 0;
+        for (int step = top_bit; step > 0; step /= 2) {
+            if (pos + step < tree.size() && tree[pos + step] < k) {
+                pos += step;
+                k -= tree[pos];
+            }
+        }
+        return (int)pos;  // pos 是「前綴和 < k」的最後一格，所以答案的分數剛好是 pos
+    }
+    int kth_largest(int64_t k) const {
+        if (k < 1 || k > total) throw out_of_range("只有 " + to_string(total) + " 人，沒有第 " + to_string(k) + " 名");
+        return kth_smallest(total - k + 1);
+    }
+    // 前 k 名的分數 (由高到低)，同一個分數一次拿完
+    vector<int> top_k(int64_t k) const {
+        vector<int> out;
+        k = min(k, total);
+        while ((int64_t)out.size() < k) {
+            int v = kth_largest(out.size() + 1);
+            int64_t take = min<int64_t>(count_at[v], k - out.size());
+            out.insert(out.end(), take, v);
+        }
+        return out;
+    }
+    // 順便維護的統計數字 (空的分數板沒有最低 / 最高分，會 throw)
+    int64_t size() const { return total; }
+    double mean() const { return total ? (double)sum / total : 0.0; }
+    int min_value() const { return kth_smallest(1); }
+    int max_value() const { return kth_largest(1); }
+};
+
+int main(int argc, char **argv) {
+    // 用法: ./a.out [玩家數量]，預設 100 萬
+    int n = argc > 1 ? stoi(argv[1]) : 1000000;
+    if (n <= 0) {   // 跟 score_board 一樣，空的就沒有平均、最高分可以問，後面的 rng() % n 也會除以 0
+        cout << "玩家數量至少要 1 人" << endl;
+        return 1;
+    }
+    const int domain = 1000000;
+    const int K = 10;
+    mt19937 rng(7);
+    uniform_int_distribution<int> score(0, domain - 1);
+
+    vector<int> v(n);
+    score_board board(domain);
+    for (int &s : v) {
+        s = score(rng);
+        board.insert(s);
+    }
+    cout << "玩家: " << board.size() << " 人，平均 " << board.mean() << " 分，最低 " << board.min_value()
+         << "，最高 " << board.max_value() << endl;
+
+    // 範圍外的輸入：查詢直接夾到範圍內，修改和空的分數板則是 throw
+    cout << "超過 -5 分的有 " << board.count_greater(-5) << " 人，超過 2000000 分的有 "
+         << board.count_greater(2000000) << " 人" << endl;
+    try {
+        board.insert(-1);
+    }
+    catch (const exception &e) {
+        cout << "insert(-1): " << e.what() << endl;
+    }
+    try {
+        score_board empty(100);
+        empty.max_value();
+    }
+    catch (const exception &e) {
+        cout << "空的分數板: " << e.what() << endl;
+    }
+
+    // 每一輪：有一個玩家的分數變了，然後儀表板問三個問題
+    // 兩種做法跑同樣的變動、同樣的問題，分開計時，最後對答案
+    struct change { int who, new_score, threshold, me; };
+    auto make_rounds = [&](int count) {
+        vector<change> cs(count);
+        for (auto &c : cs) c = {int(rng() % n), score(rng), score(rng), score(rng)};
+        return cs;
+    };
+    struct answer {
+        int64_t greater, my_rank;
+        vector<int> top;
+        bool operator==(const answer&) const = default;
+    };
+
+    // 1. 原本的做法：每一輪都用 count_if / partial_sort_copy 把整個 vector 重掃
+    vector<change> few = make_rounds(200);
+    vector<int> v_scan = v;
+    vector<answer> scan_answers;
+    auto t0 = chrono::steady_clock::now();
+    for (const change &c : few) {
+        v_scan[c.who] = c.new_score;
+        answer a;
+        a.greater = count_if(v_scan.begin(), v_scan.end(), [&](int s) { return s > c.threshold; });
+        a.my_rank = count_if(v_scan.begin(), v_scan.end(), [&](int s) { return s > c.me; }) + 1;
+        a.top.resize(min(K, n));
+        partial_sort_copy(v_scan.begin(), v_scan.end(), a.top.begin(), a.top.end(), [](int x, int y) { return x > y; });
+        scan_answers.push_back(move(a));
+    }
+    double scan_us = chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count() / few.size();
+
+    // 2. Fenwick 樹：只更新變動的那一筆，查詢都是 O(log D)
+    // 先跑同樣的 200 輪對答案
+    bool same = true;
+    for (size_t i = 0; i < few.size(); i++) {
+        const change &c = few[i];
+        board.update(v[c.who], c.new_score);
+        v[c.who] = c.new_score;
+        answer a{board.count_greater(c.threshold), board.rank(c.me), board.top_k(K)};
+        same = same && a == scan_answers[i];
+    }
+    // 再跑 100 萬輪量速度
+    vector<change> many = make_rounds(1000000);
+    int64_t checksum = 0;
+    t0 = chrono::steady_clock::now();
+    for (const change &c : many) {
+        board.update(v[c.who], c.new_score);
+        v[c.who] = c.new_score;
+        checksum += board.count_greater(c.threshold) + board.rank(c.me);
+        for (int s : board.top_k(K)) checksum += s;
+    }
+    double tree_us = chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count() / many.size();
+
+    cout << "兩種做法的答案" << (same ? "完全一致" : "不一致!") << endl;
+    cout << "每一輪 (1 次修改 + 超過門檻人數 + 名次 + 前 " << K << " 名):" << endl;
+    cout << "  count_if / partial_sort_copy 重掃: " << scan_us << " 微秒" << endl;
+    cout << "  Fenwick 樹:                        " << tree_us << " 微秒 (" << scan_us / tree_us << " 倍快)" << endl;
+    cout << "  (checksum " << checksum << "，平均分數 " << board.mean() << ")" << endl;
+    return same ? 0 : 1;
+}
+// 重點筆記：
+// 1. 同樣的問題一直問、資料又一直小幅變動時，不要每次重算，改成「資料變了就更新統計結構」(增量計算)。
+// 2. Fenwick 樹存的是「每個分數有幾人」的前綴和，修改和查詢都只碰 log D 個格子。
+// 3. 第 k 名用「從最高位往下走」的二分法，不需要另外排序。
+// 4. 前提是值域有限；值域太大或是浮點數，要先離散化，或改用平衡樹 (order-statistics tree)。
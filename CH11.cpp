@@ -72,3 +72,967 @@ int main() {
 // Throw: throw runtime_error("訊息"); 用來報警。
 // Try-Catch: 用來接住錯誤。catch(const exception& e) 是標準姿勢。
 // 安全性: 搭配 RAII (智慧指標)，就算發生異常，資源也能自動回收，這是 C++ 最讓人安心的設計。
+
+
+// 補充 : 時間都花到哪裡去了？ (Tracing 追蹤點)
+// 到目前為止，我們唯一的「觀察工具」就是在建構子、deposit、attack 裡面 cout 一行字。
+// 但 cout 本身就很慢 (要格式化、要加鎖、要寫到終端機)，拿它來量效能，量到的大多是 cout 自己。
+// 專業的做法是「追蹤點 (trace point)」：
+// a. 進入函式時記下時間，離開時再記一次 —— 這正好是 RAII：建構子記開始，解構子記結束。
+//    (就算中途 throw，Stack Unwinding 也會呼叫解構子，所以丟出異常的那一次也量得到！)
+// b. 時間用 CPU 的時間戳記計數器 rdtsc 讀，一次只要幾奈秒，比呼叫作業系統的時鐘便宜很多。
+// c. 每個執行緒寫自己的緩衝區，完全不用鎖，也不會跟別的 CPU 核心搶快取。
+// d. 程式結束時匯出成 Chrome Trace 的 JSON，丟進 chrome://tracing 或 ui.perfetto.dev 就能看到時間軸。
+// e. 編譯時加上 -DTRACE_ENABLED=0，所有追蹤點都變成空的，成本是零 (連變數都不會留下)。
+
+// 程式碼範例：TRACE_SCOPE
+#include <iostream>
+#include <fstream>
+#include <iomanip>   // fixed, setprecision
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>  // __rdtsc
+#endif
+using namespace std;
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1
+#endif
+constexpr bool trace_enabled = TRACE_ENABLED;
+
+// 讀時間戳記：x86 用 rdtsc，其他平台退回 steady_clock
+inline uint64_t trace_now() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+// 程式啟動時的時間戳記，匯出時所有事件都以它為 0
+const uint64_t trace_epoch = trace_now();
+const chrono::steady_clock::time_point clock_epoch = chrono::steady_clock::now();
+
+struct trace_event {
+    const char *name;  // 必須是字串常值 (活得跟程式一樣久)，這樣記錄時只要存一個指標
+    uint64_t start;
+    uint64_t end;
+};
+
+// 每個執行緒一個緩衝區：只有自己寫，匯出的人只讀 count 之前的部分，所以不需要鎖
+class trace_buffer {
+private:
+    size_t capacity;
+    unique_ptr<trace_event[]> events;  // () 先歸零：分頁在登記時就碰過，熱路徑上不會再缺頁
+    atomic<size_t> count{0};
+    atomic<size_t> lost{0};   // 只有自己會加，但匯出的執行緒要讀，所以也用 atomic
+public:
+    int tid;
+    bool retired = false;     // 主人 (執行緒) 已經結束了；由 tracer 的鎖保護
+    trace_buffer(int id, size_t cap) : capacity(cap), events(new trace_event[cap]()), tid(id) {}
+    void record(const char *name, uint64_t start, uint64_t end) {
+        size_t n = count.load(memory_order_relaxed);
+        if (n == capacity) {   // 滿了就丟掉新的，絕對不在熱路徑上等待
+            lost.store(lost.load(memory_order_relaxed) + 1, memory_order_relaxed);  // 只有一個寫入者，不需要 fetch_add
+            return;
+        }
+        events[n] = {name, start, end};
+        count.store(n + 1, memory_order_release);  // 先寫內容，再公開數量
+    }
+    // 只能在「沒有人在寫」的時候呼叫 (主人已經結束，新主人還沒拿到)
+    void reset(int id) {
+        count.store(0, memory_order_relaxed);
+        lost.store(0, memory_order_relaxed);
+        tid = id;
+        retired = false;
+    }
+    size_t size() const { return count.load(memory_order_acquire); }
+    size_t dropped() const { return lost.load(memory_order_relaxed); }
+    size_t bytes() const { return capacity * sizeof(trace_event); }
+    const trace_event &operator[](size_t i) const { return events[i]; }
+};
+
+// 所有執行緒的緩衝區都登記在這裡 (只有「第一次」追蹤時會上鎖)
+// 一個緩衝區預設 1<<16 個事件 (約 1.5MB)，可以用 set_capacity 調整。
+// 執行緒結束時緩衝區先留著 (它的事件還沒匯出)，匯出之後才回收給下一個新執行緒用，
+// 所以記憶體只跟「同時活著的執行緒數」有關，不會因為執行緒來來去去一直長大。
+class tracer {
+private:
+    mutex mu;
+    vector<unique_ptr<trace_buffer>> buffers;  // 全部的緩衝區 (包含已經回收、等人再用的)
+    vector<trace_buffer *> spare;              // 匯出過、主人也結束了，可以給新執行緒用
+    size_t capacity = 1 << 16;
+    size_t recycled_lost = 0;                  // 回收掉的緩衝區當初丟了幾個事件
+    int next_tid = 1;
+
+    // 執行緒結束時 (thread_local 解構) 通知 tracer
+    struct owner {
+        trace_buffer *buf = nullptr;
+        ~owner() {
+            if (buf != nullptr) tracer::get().retire(buf);
+        }
+    };
+    void retire(trace_buffer *b) {
+        lock_guard<mutex> lk(mu);
+        b->retired = true;
+    }
+    size_t dropped_locked() const {
+        size_t lost = recycled_lost;
+        for (auto &b : buffers) lost += b->dropped();
+        return lost;
+    }
+public:
+    static tracer &get() {
+        static tracer t;
+        return t;
+    }
+    // 之後「新配置」的緩衝區能放幾個事件
+    void set_capacity(size_t events) {
+        lock_guard<mutex> lk(mu);
+        capacity = events;
+    }
+    trace_buffer &local() {
+        thread_local owner mine;
+        if (mine.buf == nullptr) {
+            lock_guard<mutex> lk(mu);
+            if (!spare.empty()) {
+                mine.buf = spare.back();
+                spare.pop_back();
+                mine.buf->reset(next_tid++);
+            }
+            else {
+                buffers.push_back(make_unique<trace_buffer>(next_tid++, capacity));
+                mine.buf = buffers.back().get();
+            }
+        }
+        return *mine.buf;
+    }
+    // 匯出成 Chrome Trace / Perfetto 看得懂的 JSON ("ph":"X" = 有開始和長度的完整事件)
+    // 匯出之後，已經結束的執行緒的緩衝區會被回收 (它們的事件已經在這個檔案裡了，下次匯出不會再出現)
+    size_t export_json(const string &path) {
+        // 用這段時間校正「幾個 tick = 1 微秒」
+        double us = chrono::duration<double, micro>(chrono::steady_clock::now() - clock_epoch).count();
+        double ticks_per_us = (trace_now() - trace_epoch) / us;
+        lock_guard<mutex> lk(mu);
+        ofstream out(path);
+        out << fixed << setprecision(3);
+        out << "{\"traceEvents\":[\n";
+        size_t total = 0;
+        for (auto &b : buffers) {
+            for (size_t i = 0; i < b->size(); i++) {
+                const trace_event &e = (*b)[i];
+                out << (total++ ? ",\n" : "") << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << b->tid
+                    << ",\"ts\":" << (e.start - trace_epoch) / ticks_per_us << ",\"dur\":" << (e.end - e.start) / ticks_per_us << "}";
+            }
+        }
+        // 被丟掉的事件數量也寫進檔案 (otherData 會顯示在 Perfetto 的 metadata 裡)，不然時間軸少了一段也看不出來
+        out << "\n],\"otherData\":{\"dropped_events\":" << dropped_locked() << "}}\n";
+        for (auto &b : buffers) {
+            if (!b->retired) continue;
+            recycled_lost += b->dropped();
+            b->reset(0);
+            spare.push_back(b.get());
+        }
+        return total;
+    }
+    size_t dropped() {
+        lock_guard<mutex> lk(mu);
+        return dropped_locked();
+    }
+    // 緩衝區總共佔了多少記憶體
+    size_t memory_bytes() {
+        lock_guard<mutex> lk(mu);
+        size_t n = 0;
+        for (auto &b : buffers) n += b->bytes();
+        return n;
+    }
+};
+
+// 範圍計時器：建構子記開始，解構子記結束並寫進緩衝區
+template <bool On>
+class trace_scope {
+private:
+    trace_buffer &buf;  // 先拿緩衝區再開始計時，第一次登記的成本不會算進被量的函式
+    const char *name;
+    uint64_t start;
+public:
+    explicit trace_scope(const char *n) : buf(tracer::get().local()), name(n), start(trace_now()) {}
+    ~trace_scope() { buf.record(name, start, trace_now()); }
+};
+// 關掉的版本：什麼都沒有，編譯器會把它整個刪掉
+template <>
+class trace_scope<false> {
+public:
+    constexpr explicit trace_scope(const char *) {}
+};
+
+// 巨集只負責產生一個不重複的變數名稱 (trace_行號)
+#define TRACE_CAT2(a, b) a##b
+#define TRACE_CAT(a, b) TRACE_CAT2(a, b)
+#define TRACE_SCOPE(name) trace_scope<trace_enabled> TRACE_CAT(trace_, __LINE__)(name)
+
+// ---- 第一批用戶：各章的熱路徑 ----
+class bankaccount {   // CH2 (熱路徑上不再 cout)
+private:
+    string owner;
+    int balance = 0;
+public:
+    void init(string n, int amount) {
+        TRACE_SCOPE("bankaccount::init");
+        owner = move(n);
+        balance = amount < 0 ? 0 : amount;
+    }
+    void deposit(int amount) {
+        TRACE_SCOPE("bankaccount::deposit");
+        if (amount > 0) balance += amount;
+    }
+    int getbalance() const { return balance; }
+};
+class player {        // CH4
+public:
+    string name;
+    int swings = 0;
+    player(string n) : name(move(n)) { TRACE_SCOPE("player::player"); }
+    ~player() { TRACE_SCOPE("player::~player"); }
+    void attack() {
+        TRACE_SCOPE("player::attack");
+        swings++;
+    }
+};
+class Character {     // CH6
+public:
+    string name;
+    int damage = 0;
+    Character(string n) : name(move(n)) {}
+    virtual ~Character() {}
+    virtual void attack() {
+        TRACE_SCOPE("Character::attack");
+        damage += 1;
+    }
+};
+class Warrior : public Character {
+public:
+    Warrior(string n) : Character(move(n)) {}
+    void attack() override {
+        TRACE_SCOPE("Warrior::attack");
+        damage += 10;
+    }
+};
+double divide(double a, double b) {   // CH11
+    TRACE_SCOPE("divide");
+    if (b == 0) throw runtime_error("分母不能為 0");  // 丟出異常時 trace_scope 照樣被解構，這一次也會被記錄
+    return a / b;
+}
+
+// 一個「遊戲回合」：會用到上面所有的追蹤點
+void game_tick(bankaccount &bank, int round) {
+    TRACE_SCOPE("game_tick");
+    player p("Justin");
+    Warrior w("亞瑟");
+    Character *c = &w;
+    for (int i = 0; i < 3; i++) {
+        p.attack();
+        c->attack();
+    }
+    bank.deposit(round % 100);
+    try {
+        divide(round, round % 10);
+    }
+    catch (const exception &) {
+        // 每 10 回合除以 0 一次，正好看看異常路徑花多少時間
+    }
+}
+
+int main() {
+    cout << "追蹤 " << (trace_enabled ? "開啟" : "關閉 (-DTRACE_ENABLED=0)") << endl;
+
+    // 1. 三個執行緒一起跑遊戲回合，各自寫自己的緩衝區
+    vector<thread> workers;
+    for (int t = 0; t < 3; t++) {
+        workers.emplace_back([] {
+            bankaccount bank;
+            bank.init("Justin", 1000);
+            for (int round = 0; round < 2000; round++) game_tick(bank, round);
+        });
+    }
+    for (auto &w : workers) w.join();
+
+    // 2. 追蹤點本身的成本：同一支程式用 -DTRACE_ENABLED=0 再編一次，比較這個數字
+    //    主執行緒要記 50 萬筆，預設的緩衝區放不下，先把容量開大 (只影響之後才配置的緩衝區)
+    tracer::get().set_capacity(1 << 20);
+    bankaccount bank;
+    bank.init("Justin", 0);
+    const int n = 500000;
+    auto t0 = chrono::steady_clock::now();
+    for (int i = 0; i < n; i++) bank.deposit(1);
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count() / n;
+    cout << "deposit 平均 " << ns << " ns (餘額 " << bank.getbalance() << ")" << endl;
+
+    // 3. 匯出時間軸
+    size_t events = tracer::get().export_json("trace.json");
+    cout << "匯出 " << events << " 個事件到 trace.json，用 chrome://tracing 或 ui.perfetto.dev 打開" << endl;
+    cout << "緩衝區滿了丟掉 " << tracer::get().dropped() << " 個事件" << endl;
+
+    // 4. 執行緒來來去去：每一批執行緒結束、匯出之後，它們的緩衝區就回收給下一批用，記憶體不會一直長
+    tracer::get().set_capacity(1 << 16);
+    size_t before = tracer::get().memory_bytes();
+    for (int wave = 0; wave < 5; wave++) {
+        vector<thread> batch;
+        for (int t = 0; t < 3; t++) {
+            batch.emplace_back([] {
+                bankaccount b;
+                for (int round = 0; round < 100; round++) game_tick(b, round);
+            });
+        }
+        for (auto &w : batch) w.join();
+        tracer::get().export_json("trace_waves.json");
+    }
+    cout << "再跑 5 批 x 3 條執行緒: 追蹤緩衝區 " << before / 1024 << " KB -> " << tracer::get().memory_bytes() / 1024
+         << " KB" << endl;
+    return 0;
+}
+// 重點筆記：
+// 1. 追蹤點就是 RAII 的應用：建構子記開始、解構子記結束，連 throw 出去的那一次都不會漏。
+// 2. 熱路徑上不要 cout、不要上鎖：每個執行緒寫自己的緩衝區，最後才統一匯出。
+// 3. 用樣板特化 + constexpr 開關做「編譯期移除」：關掉時 trace_scope<false> 是空類別，成本是零。
+// 4. 量效能要用便宜的尺：rdtsc 比 cout 便宜好幾個數量級，才不會「量的人比被量的還慢」。
+// 5. 緩衝區滿了丟資料可以，但一定要數、要回報：不說的話，看時間軸的人會以為那段時間什麼都沒發生。
+// 6. 每條執行緒一塊緩衝區，就要想清楚「執行緒結束之後誰來收」：匯出完就回收重用，容量也要能調。
+
+
+// 補充 : 一次開幾百萬個帳戶 (批次驗證 + 錯誤表，不用一筆一筆 throw)
+// CH2 的 bankaccount::init 遇到負數會印 "Error!" 然後偷偷改成 0；本章則是一個錯誤丟一個例外。
+// 這兩種做法處理「一筆」資料很合理，但匯入開戶檔 (幾百萬行) 時就不行了：
+// 1. 每個錯誤都 cout 或 throw，壞掉的行越多就越慢 (丟例外要解開堆疊，比 return 貴上千倍)。
+// 2. 錯誤訊息散落在螢幕上，事後無法統計「哪幾行、錯在哪裡」。
+// 3. 一邊驗證一邊開戶，檔案驗證到一半才發現問題，前面的帳戶已經開了，收不回來。
+// 批次的做法：
+// 1. 把檔案切成幾塊 (切在換行的地方)，每條執行緒驗證自己那一塊，驗證只回傳錯誤代碼 (1 byte)，不 throw、不印。
+// 2. 錯誤收進一張緊湊的錯誤表：{第幾行, 錯誤代碼}，另外統計每種錯誤的數量。
+// 3. 全部驗證完，再把「合格的行」一次寫進帳本 (先在旁邊建好，最後才一次接上去，中途失敗帳本不會被改到一半)。
+// 例外並沒有消失：它留給真正「意料之外」的錯誤 (例如記憶體不足)，而不是「輸入檔有一行寫錯」這種意料之內的事。
+
+// 程式碼範例：
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <charconv>
+#include <stdexcept>
+#include <algorithm>
+#include <cstdint>
+#include <climits>
+using namespace std;
+
+class bankaccount {   // CH2 (驗證已經在外面做完了，這裡不會再印 Error!)
+private:
+    string owner;
+    int balance = 0;
+public:
+    void init(string n, int amount) {
+        owner = move(n);
+        if (amount < 0) {
+            balance = 0;
+            cout << "Error!" << endl;
+        }
+        else {
+            balance = amount;
+        }
+    }
+    int getbalance() const { return balance; }
+};
+
+// 錯誤代碼只要 1 個 byte
+enum class row_error : uint8_t {
+    ok,
+    missing_field,     // 少了逗號
+    extra_field,       // 多了欄位
+    empty_owner,
+    owner_too_long,
+    bad_amount,        // 不是數字
+    negative_amount,
+    amount_overflow,   // 超過 int 的範圍
+    count
+};
+const char *error_name(row_error e) {
+    static const char *names[] = {"ok", "少了欄位", "多了欄位", "戶名是空的", "戶名太長",
+                                  "金額不是數字", "金額是負的", "金額太大"};
+    return names[(int)e];
+}
+
+struct account_row {
+    string_view owner;      // 直接指向原本的檔案內容，不複製
+    int amount;
+};
+struct error_entry {
+    uint32_t line;          // 第幾行 (從 1 開始)
+    row_error code;
+};
+
+// 驗證一行：只回傳錯誤代碼，成功時把結果寫進 out
+row_error validate_row(string_view line, account_row &out) {
+    size_t comma = line.find(',');
+    if (comma == string_view::npos) return row_error::missing_field;
+    string_view owner = line.substr(0, comma), amount = line.substr(comma + 1);
+    if (amount.find(',') != string_view::npos) return row_error::extra_field;
+    if (owner.empty()) return row_error::empty_owner;
+    if (owner.size() > 32) return row_error::owner_too_long;
+    long long v = 0;
+    auto [end, ec] = from_chars(amount.data(), amount.data() + amount.size(), v);
+    if (ec == errc::result_out_of_range) return row_error::amount_overflow;
+    if (ec != errc() || end != amount.data() + amount.size() || amount.empty()) return row_error::bad_amount;
+    if (v < 0) return row_error::negative_amount;
+    if (v > INT_MAX) return row_error::amount_overflow;
+    out = {owner, (int)v};
+    return row_error::ok;
+}
+
+// 一塊資料的驗證結果 (每條執行緒各一份，不共用，不用上鎖)
+struct chunk_result {
+    vector<account_row> valid;
+    vector<error_entry> errors;   // line 先記「塊內第幾行」，合併時再加上前面幾塊的行數
+    uint32_t lines = 0;
+};
+
+void validate_chunk(string_view text, chunk_result &r) {
+    r.valid.reserve(text.size() / 16);
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t nl = text.find('\n', pos);
+        if (nl == string_view::npos) nl = text.size();
+        string_view line = text.substr(pos, nl - pos);
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        r.lines++;
+        account_row row;
+        row_error e = validate_row(line, row);
+        if (e == row_error::ok) r.valid.push_back(row);
+        else r.errors.push_back({r.lines, e});
+        pos = nl + 1;
+    }
+}
+
+struct validation_report {
+    vector<account_row> valid;
+    vector<error_entry> errors;
+    uint32_t count[(int)row_error::count] = {};
+    uint32_t lines = 0;
+};
+
+// 切塊 -> 平行驗證 -> 依照原本的順序合併
+validation_report validate_all(string_view text, int threads) {
+    vector<string_view> chunks;
+    size_t begin = 0;
+    for (int t = 0; t < threads && begin < text.size(); t++) {
+        size_t end = t == threads - 1 ? text.size() : text.size() * (t + 1) / threads;
+        end = max(end, begin);
+        while (end > 0 && end < text.size() && text[end - 1] != '\n') end++;   // 往後找到換行才切
+        chunks.push_back(text.substr(begin, end - begin));
+        begin = end;
+    }
+    vector<chunk_result> results(chunks.size());
+    vector<thread> workers;
+    for (size_t i = 0; i < chunks.size(); i++) {
+        workers.emplace_back([&, i] { validate_chunk(chunks[i], results[i]); });
+    }
+    for (auto &w : workers) w.join();
+
+    validation_report rep;
+    size_t valid = 0;
+    for (auto &r : results) valid += r.valid.size();
+    rep.valid.reserve(valid);
+    for (auto &r : results) {
+        rep.valid.insert(rep.valid.end(), r.valid.begin(), r.valid.end());
+        for (error_entry e : r.errors) {
+            e.line += rep.lines;
+            rep.errors.push_back(e);
+            rep.count[(int)e.code]++;
+        }
+        rep.lines += r.lines;
+    }
+    rep.count[(int)row_error::ok] = valid;
+    return rep;
+}
+
+// 帳本：一次提交一整批
+class ledger {
+private:
+    vector<bankaccount> accounts;
+public:
+    // 先在旁邊把新帳戶都建好 (這裡可能 throw bad_alloc)，成功了才一次接到帳本後面
+    // 所以要嘛整批都進去，要嘛帳本完全沒變
+    void commit(const vector<account_row> &rows) {
+        vector<bankaccount> fresh(rows.size());
+        for (size_t i = 0; i < rows.size(); i++) fresh[i].init(string(rows[i].owner), rows[i].amount);
+        accounts.reserve(accounts.size() + fresh.size());
+        move(fresh.begin(), fresh.end(), back_inserter(accounts));
+    }
+    size_t size() const { return accounts.size(); }
+    long long total() const {
+        long long s = 0;
+        for (auto &a : accounts) s += a.getbalance();
+        return s;
+    }
+};
+
+// 對照組：一行一行處理，錯了就 throw，在外面 catch
+int parse_or_throw(string_view line, string &owner) {
+    size_t comma = line.find(',');
+    if (comma == string_view::npos) throw invalid_argument("少了欄位");
+    owner = string(line.substr(0, comma));
+    if (owner.empty()) throw invalid_argument("戶名是空的");
+    int v = stoi(string(line.substr(comma + 1)));   // 不是數字 / 太大也會 throw
+    if (v < 0) throw invalid_argument("金額是負的");
+    return v;
+}
+
+// 產生測試用的開戶檔：bad_every 行裡面放一行壞掉的
+string make_file(size_t rows, size_t bad_every) {
+    static const char *bad[] = {"Justin", ",100", "Justin,-5", "Justin,abc", "Justin,99999999999",
+                                "Justin,1,2", "ThisOwnerNameIsDefinitelyWayTooLongToBeValid,1"};
+    string s;
+    s.reserve(rows * 16);
+    for (size_t i = 0; i < rows; i++) {
+        if (bad_every && i % bad_every == bad_every - 1) {
+            s += bad[(i / bad_every) % 7];
+        }
+        else {
+            s += "user";
+            s += to_string(i % 100000);
+            s += ',';
+            s += to_string(i % 5000);
+        }
+        s += '\n';
+    }
+    return s;
+}
+
+int main(int argc, char **argv) {
+    // 用法: ./a.out [行數] [執行緒數]，預設 500 萬行、所有核心
+    size_t rows = argc > 1 ? stoul(argv[1]) : 5000000;
+    int threads = argc > 2 ? stoi(argv[2]) : max(1u, thread::hardware_concurrency());
+    string file = make_file(rows, 100);   // 1% 的行是壞的
+
+    // 1. 批次：平行驗證 + 錯誤表 + 一次提交
+    ledger bank;
+    auto t0 = chrono::steady_clock::now();
+    validation_report rep = validate_all(file, threads);
+    auto t1 = chrono::steady_clock::now();
+    bank.commit(rep.valid);
+    auto t2 = chrono::steady_clock::now();
+    double v_sec = chrono::duration<double>(t1 - t0).count();
+    double all_sec = chrono::duration<double>(t2 - t0).count();
+
+    cout << rep.lines << " 行，" << threads << " 條執行緒" << endl;
+    cout << "驗證: " << v_sec << " 秒 (" << rep.lines / v_sec / 1e6 << " 百萬行/秒)，"
+         << "驗證+開戶: " << all_sec << " 秒 (" << rep.lines / all_sec / 1e6 << " 百萬行/秒)" << endl;
+    cout << "開了 " << bank.size() << " 個帳戶，總存款 " << bank.total() << endl;
+    cout << "錯誤表 (" << rep.errors.size() << " 筆, 每筆 " << sizeof(error_entry) << " bytes):" << endl;
+    for (int c = 1; c < (int)row_error::count; c++) {
+        if (rep.count[c]) cout << "  " << error_name((row_error)c) << ": " << rep.count[c] << endl;
+    }
+    for (size_t i = 0; i < min<size_t>(3, rep.errors.size()); i++) {
+        cout << "  例如第 " << rep.errors[i].line << " 行: " << error_name(rep.errors[i].code) << endl;
+    }
+
+    // 2. 對照組：一行一行 try / catch
+    size_t ok = 0, failed = 0;
+    long long total = 0;
+    t0 = chrono::steady_clock::now();
+    string_view text = file;
+    string owner;
+    for (size_t pos = 0; pos < text.size();) {
+        size_t nl = text.find('\n', pos);
+        try {
+            total += parse_or_throw(text.substr(pos, nl - pos), owner);
+            ok++;
+        }
+        catch (const exception &) {
+            failed++;
+        }
+        pos = nl + 1;
+    }
+    double e_sec = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    cout << "對照組 (一行一個 try/catch，只驗證不開戶): " << e_sec << " 秒 (" << rows / e_sec / 1e6
+         << " 百萬行/秒)，成功 " << ok << "，失敗 " << failed << endl;
+    // 注意：對照組比較寬鬆 (stoi 會接受 "1,2" 裡的 "1")，所以失敗的數量比錯誤表少
+    return 0;
+}
+// 重點筆記：
+// 1. 「意料之內」的錯誤 (使用者輸入錯) 用錯誤代碼收集起來；「意料之外」的錯誤才用例外。
+// 2. 錯誤表只記 {行號, 1 byte 代碼}，事後可以統計、可以回報，也不會拖慢正常的行。
+// 3. 每條執行緒處理自己的一塊、寫自己的結果，最後依照順序合併，全程不用上鎖。
+// 4. 先驗證、再一次提交：帳本要嘛整批更新，要嘛完全不變 (強例外保證 strong exception guarantee)。
+
+
+// 補充 : 每秒幾百萬次的「+1」 (分片計數器 + 直方圖 + 指標登錄)
+// 想知道伺服器現在的狀況：處理了幾筆存款？出了幾次攻擊？丟了幾個例外？每次存款花了多久？
+// 最直覺的寫法是一個全域的 atomic<long> deposits; 每次 deposits++。
+// 單執行緒沒問題，但 64 條執行緒一起 ++ 同一個變數時，
+// 那條快取線要在所有核心之間輪流搬 (每次 ++ 都要搶到「獨佔」)，原本 1 ns 的事變成幾十、幾百 ns。
+// 解法：寫的時候分開，讀的時候才加總。
+// 1. 分片計數器：每條執行緒有自己的一格 (對齊 64 bytes，不和別人共用快取線)，
+//    只有自己會寫，所以不需要 lock 指令，普通的讀 + 寫就好 (約 1 ns)。
+//    讀取 (很少發生) 時才把所有執行緒的格子加起來。
+// 2. 直方圖 (HDR 風格)：數值依照「2 的幾次方 + 前 3 個位元」分桶，
+//    從 1 到 2^64 只要 496 個桶，每個桶的相對誤差 <= 12.5%，可以算 p50 / p99。同樣每條執行緒一份。
+// 3. 登錄 (registry)：用名字註冊指標 (很少發生，可以上鎖)；熱路徑拿著參考直接用，不查表。
+//    snapshot() 一次讀出所有指標，再輸出成文字 (Prometheus 的格式)。
+
+// 程式碼範例：
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <stdexcept>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <ctime>
+#include <new>       // nothrow
+using namespace std;
+
+// 每條執行緒一個編號 (0 ~ max_threads-1)，執行緒結束時還回去，下一條執行緒接著用
+// (格子裡的數字不清掉：結束的執行緒做過的事還是要算進總數)
+// 同時超過 max_threads 條的話，多出來的執行緒共用最後一格 overflow_slot (用 fetch_add，慢一點但不會錯)。
+// 指標是掛在 deposit 這種熱路徑上的，不管發生什麼事都不能 throw —— 錢都已經加上去了，這時候丟例外只會讓狀態說不清楚
+const int max_threads = 256;
+const int overflow_slot = max_threads;
+const int total_slots = max_threads + 1;
+class thread_slots {
+private:
+    atomic<bool> used[max_threads] = {};
+    struct holder {
+        int index = -1;
+        ~holder() {
+            if (index >= 0 && index < max_threads) thread_slots::get().used[index].store(false, memory_order_release);
+        }
+    };
+public:
+    static thread_slots &get() {
+        static thread_slots s;
+        return s;
+    }
+    static int mine() noexcept {
+        static thread_local holder h;
+        if (h.index < 0) {
+            h.index = overflow_slot;   // 找不到空位就用共用的那一格
+            for (int i = 0; i < max_threads; i++) {
+                bool expected = false;
+                if (get().used[i].compare_exchange_strong(expected, true)) {
+                    h.index = i;
+                    break;
+                }
+            }
+        }
+        return h.index;
+    }
+};
+
+// 只有「擁有者執行緒」會寫的數字：load + store 不需要 lock 指令，但讀的人看得到 (不是 data race)
+inline void owner_add(atomic<uint64_t> &a, uint64_t n) {
+    a.store(a.load(memory_order_relaxed) + n, memory_order_relaxed);
+}
+// 寫進第 slot 格：自己的格子用 owner_add，共用的 overflow 格子好幾個人一起寫，要用真正的原子操作
+inline void slot_add(atomic<uint64_t> &a, uint64_t n, int slot) {
+    if (slot == overflow_slot) a.fetch_add(n, memory_order_relaxed);
+    else owner_add(a, n);
+}
+inline void slot_max(atomic<uint64_t> &a, uint64_t v, int slot) {
+    uint64_t cur = a.load(memory_order_relaxed);
+    if (slot != overflow_slot) {
+        if (v > cur) a.store(v, memory_order_relaxed);
+        return;
+    }
+    while (v > cur && !a.compare_exchange_weak(cur, v, memory_order_relaxed)) {}
+}
+
+// 1. 分片計數器
+class counter {
+private:
+    struct alignas(64) cell {
+        atomic<uint64_t> v{0};
+    };
+    unique_ptr<cell[]> cells{new cell[total_slots]};
+public:
+    void add(uint64_t n = 1) noexcept {
+        int slot = thread_slots::mine();
+        slot_add(cells[slot].v, n, slot);
+    }
+    uint64_t value() const {                  // 讀的時候才加總
+        uint64_t s = 0;
+        for (int i = 0; i < total_slots; i++) s += cells[i].v.load(memory_order_relaxed);
+        return s;
+    }
+};
+
+// 2. HDR 風格的直方圖
+class histogram {
+public:
+    static const int buckets = 16 + 60 * 8;   // 0~15 各一桶，之後每個 2 的次方再分 8 桶
+    static int bucket_of(uint64_t v) {
+        if (v < 16) return (int)v;
+        int e = bit_width(v) - 1;             // 最高位元在第幾位
+        return 16 + (e - 4) * 8 + (int)((v >> (e - 3)) & 7);
+    }
+    static uint64_t bucket_upper(int b) {    // 這一桶最大的值
+        if (b < 16) return b;
+        int e = (b - 16) / 8 + 4, m = (b - 16) % 8;
+        return ((uint64_t)(8 + m + 1) << (e - 3)) - 1;
+    }
+    struct snapshot {
+        vector<uint64_t> counts = vector<uint64_t>(buckets, 0);
+        uint64_t count = 0, sum = 0, max = 0;
+        // 第 p 百分位數 (回傳那一桶的上界，誤差 <= 12.5%)
+        uint64_t percentile(double p) const {
+            if (count == 0) return 0;
+            uint64_t rank = max_of(1, (uint64_t)(p / 100.0 * count + 0.5)), seen = 0;
+            for (int b = 0; b < buckets; b++) {
+                seen += counts[b];
+                if (seen >= rank) return min(bucket_upper(b), max);
+            }
+            return max;
+        }
+        static uint64_t max_of(uint64_t a, uint64_t b) { return a > b ? a : b; }
+    };
+private:
+    struct alignas(64) shard {
+        atomic<uint64_t> sum{0}, max{0};   // 總筆數不另外存，讀的時候由各桶加總
+        atomic<uint64_t> counts[buckets] = {};
+    };
+    unique_ptr<atomic<shard*>[]> shards{new atomic<shard*>[total_slots]};  // 第一次記錄時才配置
+public:
+    histogram() {
+        for (int i = 0; i < max_threads; i++) shards[i].store(nullptr);
+        shards[overflow_slot].store(new shard);   // 共用的那一份先配好，熱路徑上配置失敗時也有地方寫
+    }
+    ~histogram() {
+        for (int i = 0; i < total_slots; i++) delete shards[i].load();
+    }
+    void record(uint64_t v) noexcept {
+        int i = thread_slots::mine();
+        shard *s = shards[i].load(memory_order_acquire);
+        if (s == nullptr) {
+            s = new (nothrow) shard;
+            if (s != nullptr) shards[i].store(s, memory_order_release);
+            else s = shards[i = overflow_slot].load(memory_order_relaxed);   // 記憶體不夠：改寫共用的那一份
+        }
+        slot_add(s->counts[bucket_of(v)], 1, i);
+        slot_add(s->sum, v, i);
+        slot_max(s->max, v, i);
+    }
+    snapshot read() const {
+        snapshot out;
+        for (int i = 0; i < total_slots; i++) {
+            shard *s = shards[i].load(memory_order_acquire);
+            if (s == nullptr) continue;
+            for (int b = 0; b < buckets; b++) out.counts[b] += s->counts[b].load(memory_order_relaxed);
+            out.sum += s->sum.load(memory_order_relaxed);
+            out.max = max(out.max, s->max.load(memory_order_relaxed));
+        }
+        // 讀的同時可能還有人在寫：count 如果另外讀，會跟各桶對不起來，percentile() 算出來的排名就會落空。
+        // 直接用各桶的加總，兩者一定一致
+        for (int b = 0; b < buckets; b++) out.count += out.counts[b];
+        return out;
+    }
+};
+
+// 3. 指標登錄
+class metrics_registry {
+private:
+    mutex mu;
+    map<string, unique_ptr<counter>> counters;
+    map<string, unique_ptr<histogram>> histograms;
+public:
+    struct snapshot {
+        vector<pair<string, uint64_t>> counters;
+        vector<pair<string, histogram::snapshot>> histograms;
+    };
+    static metrics_registry &get() {
+        static metrics_registry r;
+        return r;
+    }
+    // 註冊 (同名就回傳同一個)，熱路徑請把回傳的參考存起來用
+    counter &get_counter(const string &name) {
+        lock_guard<mutex> lk(mu);
+        auto &c = counters[name];
+        if (!c) c = make_unique<counter>();
+        return *c;
+    }
+    histogram &get_histogram(const string &name) {
+        lock_guard<mutex> lk(mu);
+        auto &h = histograms[name];
+        if (!h) h = make_unique<histogram>();
+        return *h;
+    }
+    snapshot take_snapshot() {
+        lock_guard<mutex> lk(mu);
+        snapshot s;
+        for (auto &[name, c] : counters) s.counters.push_back({name, c->value()});
+        for (auto &[name, h] : histograms) s.histograms.push_back({name, h->read()});
+        return s;
+    }
+    // 文字輸出 (Prometheus 格式)
+    // summary 只能有 {quantile}、_sum、_count 三種樣本，最大值不屬於 summary，另外輸出成一個 gauge
+    static string to_text(const snapshot &s) {
+        ostringstream os;
+        for (auto &[name, v] : s.counters) {
+            os << "# TYPE " << name << "_total counter\n";
+            os << name << "_total " << v << "\n";
+        }
+        for (auto &[name, h] : s.histograms) {
+            os << "# TYPE " << name << " summary\n";
+            for (double q : {50.0, 90.0, 99.0, 99.9}) {
+                os << name << "{quantile=\"" << q / 100 << "\"} " << h.percentile(q) << "\n";
+            }
+            os << name << "_sum " << h.sum << "\n";
+            os << name << "_count " << h.count << "\n";
+            os << "# TYPE " << name << "_max_value gauge\n";
+            os << name << "_max_value " << h.max << "\n";
+        }
+        return os.str();
+    }
+};
+
+// ---- 各章的熱路徑裝上指標 ----
+counter &deposits = metrics_registry::get().get_counter("bank_deposits");
+counter &attacks = metrics_registry::get().get_counter("character_attacks");
+counter &exceptions = metrics_registry::get().get_counter("exceptions_thrown");
+histogram &deposit_amount = metrics_registry::get().get_histogram("bank_deposit_amount");
+
+class bankaccount {   // CH2
+private:
+    string owner;
+    int balance = 0;
+public:
+    void init(string n, int amount) {
+        owner = move(n);
+        balance = amount < 0 ? 0 : amount;
+    }
+    void deposit(int amount) {
+        if (amount > 0) {
+            balance += amount;
+            deposits.add();
+            deposit_amount.record(amount);
+        }
+    }
+    int getbalance() const { return balance; }
+};
+class Character {     // CH6
+public:
+    int damage = 0;
+    virtual ~Character() {}
+    virtual void attack() {
+        damage += 1;
+        attacks.add();
+    }
+};
+double divide(double a, double b) {   // CH11
+    if (b == 0) {
+        exceptions.add();
+        throw runtime_error("分母不能為 0");
+    }
+    return a / b;
+}
+
+// 這條執行緒到目前為止用了多少 CPU 時間 (奈秒)：不受「核心比執行緒少」的影響
+double thread_cpu_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// n 條執行緒各做 ops 次 op()，回傳每次 op 平均花多少 CPU 奈秒
+template <typename F>
+double per_op_ns(int n, long ops, F op) {
+    vector<thread> ts;
+    vector<double> cpu(n);
+    atomic<int> ready{0};
+    for (int t = 0; t < n; t++) {
+        ts.emplace_back([&, t] {
+            op();                                   // 先領好執行緒編號 / 配置好分片
+            ready++;
+            while (ready.load() < n) this_thread::yield();  // 大家一起開始，才會真的互相搶
+            double c0 = thread_cpu_ns();
+            for (long i = 0; i < ops; i++) op();
+            cpu[t] = thread_cpu_ns() - c0;
+        });
+    }
+    for (auto &t : ts) t.join();
+    double total = 0;
+    for (double c : cpu) total += c;
+    return total / ((double)n * ops);
+}
+
+int main(int argc, char **argv) {
+    // 用法: ./a.out [最多幾條執行緒]，預設 64
+    int max_t = argc > 1 ? stoi(argv[1]) : 64;
+
+    // 1. 各章的熱路徑跑起來，最後看指標
+    vector<thread> workers;
+    for (int t = 0; t < 8; t++) {
+        workers.emplace_back([t] {
+            bankaccount bank;
+            bank.init("Justin", 0);
+            Character c;
+            for (int i = 0; i < 100000; i++) {
+                bank.deposit((i * 37 + t) % 1000 + 1);
+                c.attack();
+                if (i % 1000 == 0) {
+                    try {
+                        divide(i, 0);
+                    }
+                    catch (const exception &) {
+                    }
+                }
+            }
+        });
+    }
+    for (auto &w : workers) w.join();
+    cout << metrics_registry::to_text(metrics_registry::get().take_snapshot());
+
+    // 2. 每次 +1 的成本：共用的 atomic vs 分片計數器 vs 直方圖
+    atomic<uint64_t> shared{0};
+    counter sharded;
+    histogram hist;
+    const long ops = 2000000;
+    cout << "執行緒數 | atomic fetch_add | 分片計數器 | 直方圖 record   (每次平均 CPU 奈秒)" << endl;
+    for (int n = 1; n <= max_t; n *= 2) {
+        double a = per_op_ns(n, ops, [&] { shared.fetch_add(1, memory_order_relaxed); });
+        double b = per_op_ns(n, ops, [&] { sharded.add(); });
+        double c = per_op_ns(n, ops / 4, [&] {
+            static thread_local uint64_t x = 88172645463325252ull;  // 每條執行緒自己的亂數
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            hist.record(x >> 44);
+        });
+        cout << n << "\t\t" << a << "\t\t" << b << "\t\t" << c << endl;
+    }
+    bool ok = shared.load() == sharded.value();
+    cout << "atomic = " << shared.load() << "，分片加總 = " << sharded.value() << (ok ? " (一致)" : " (不一致!)") << endl;
+    cout << "(只有一個核心時，大家輪流跑，不會真的同時搶快取線，atomic 看起來就不慢；核心越多差距越大)" << endl;
+    return ok ? 0 : 1;
+}
+// 重點筆記：
+// 1. 很多執行緒一起寫的計數器，最大的成本是「搶同一條快取線」，不是加法本身。
+// 2. 分片：每條執行緒寫自己的格子 (對齊 64 bytes)，只有讀的時候才加總 —— 寫很多、讀很少時最划算。
+// 3. 直方圖用「2 的次方 + 前 3 個位元」分桶：固定 496 個桶，就能算 p99，誤差 12.5% 以內。
+// 4. 註冊時上鎖沒關係 (很少發生)，熱路徑拿著參考直接用，不要每次都用名字查表。
+// 5. 讀取時能從別的資料算出來的數字 (總筆數 = 各桶加總) 就不要另外存，存兩份在並行讀取時就可能對不起來。
+// 6. 指標絕對不能讓業務邏輯失敗：格子不夠就退到共用的格子 (fetch_add)，配置失敗也一樣，add / record 都是 noexcept。
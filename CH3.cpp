@@ -91,3 +91,300 @@ int main() {
 // 系統函式 malloc 回傳的是什麼？ 是一個地址 (void*)。
 // C++ 運算子 new 回傳的是什麼？ 也是一個地址。
 // 指標 (*) 就是專門用來裝「地址」的容器。 參考 (&) 是用來當「別名」的。
+
+
+// 補充 : 程式開得好慢 (編譯期建表、延遲初始化、啟動計時器)
+// 每一章的 main 一開始都在「建東西」：寵物、帳戶、分數陣列...
+// 真正的伺服器啟動時要建的表大上好幾萬倍，全部在 main 一開始 (或是全域變數的建構子裡) 建好，
+// 開機就要好幾秒，而且很多表第一個請求根本用不到。三個工具：
+// 1. constexpr / constinit：表格的內容在編譯期就算好，直接放在執行檔裡，啟動時間是 0。
+//    constexpr 建構子 (對，建構子也可以是 constexpr) 讓「物件」也能在編譯期就誕生。
+//    constinit 保證全域變數「一定」是編譯期初始化的 (之後還可以修改)，
+//    不會有「另一個全域變數的建構子先用到它」的初始化順序問題 (static initialization order fiasco)。
+// 2. lazy<T>：第一次用到才建 (延遲初始化)，用不到就永遠不建。多執行緒同時第一次用也只會建一次 (call_once)。
+// 3. 啟動計時器：每個初始化步驟花多少時間都記下來，啟動完印一張表，才知道該先優化哪一個。
+// 冷啟動時間用「自己 fork + exec 自己」來量：從開新程式到可以接第一個請求，總共幾毫秒。
+
+// 程式碼範例：
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <array>
+#include <optional>
+#include <functional>
+#include <algorithm>
+#include <numeric>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <unistd.h>    // fork, execv
+#include <sys/wait.h>  // waitpid
+using namespace std;
+
+// 整支程式最早初始化的東西：開始計時
+const auto process_start = chrono::steady_clock::now();
+
+// ---- 3. 啟動計時器 ----
+class startup_profiler {
+private:
+    struct entry {
+        string name;
+        double ms;
+        bool lazy;
+    };
+    mutex mu;
+    vector<entry> entries;
+public:
+    static startup_profiler &get() {
+        static startup_profiler p;
+        return p;
+    }
+    // RAII：建構時開始計時，解構時記錄
+    class scope {
+    private:
+        const char *name;
+        bool lazy;
+        chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+    public:
+        scope(const char *n, bool is_lazy = false) : name(n), lazy(is_lazy) {}
+        ~scope() {
+            double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+            startup_profiler &p = get();
+            lock_guard<mutex> lk(p.mu);
+            p.entries.push_back({name, ms, lazy});
+        }
+    };
+    void report(const char *title) {
+        lock_guard<mutex> lk(mu);
+        vector<entry> sorted = entries;
+        sort(sorted.begin(), sorted.end(), [](const entry &a, const entry &b) { return a.ms > b.ms; });
+        cout << "[" << title << "] 初始化步驟 (由慢到快):" << endl;
+        for (auto &e : sorted) {
+            cout << "  " << setw(8) << fixed << setprecision(2) << e.ms << " ms  " << e.name
+                 << (e.lazy ? " (第一次用到才建)" : "") << endl;
+        }
+    }
+};
+
+// ---- 2. 延遲初始化 ----
+template <typename T>
+class lazy {
+private:
+    const char *name;
+    function<T()> factory;
+    once_flag once;
+    optional<T> value;
+    atomic<bool> built{false};
+public:
+    lazy(const char *n, function<T()> f) : name(n), factory(move(f)) {}
+    T &get() {
+        call_once(once, [this] {
+            startup_profiler::scope s(name, true);
+            value.emplace(factory());
+            built.store(true, memory_order_release);
+        });
+        return *value;
+    }
+    T *operator->() { return &get(); }
+    bool ready() const { return built.load(memory_order_acquire); }
+};
+
+// ---- 1. 編譯期的表 ----
+// 經驗值表：第 n 級升級需要的經驗
+constexpr array<long, 100> make_exp_table() {
+    array<long, 100> t{};
+    for (int lv = 1; lv < 100; lv++) t[lv] = t[lv - 1] + lv * lv * 50 + 100;
+    return t;
+}
+// 傷害表：攻擊力 0 ~ 65535 對應的實際傷害 (整數平方根，再加一點變化)
+constexpr uint32_t isqrt(uint32_t x) {
+    uint32_t r = 0, bit = 1u << 30;
+    while (bit > x) bit >>= 2;
+    while (bit) {
+        if (x >= r + bit) {
+            x -= r + bit;
+            r = (r >> 1) + bit;
+        }
+        else {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return r;
+}
+constexpr array<uint16_t, 65536> make_damage_table() {
+    array<uint16_t, 65536> t{};
+    for (uint32_t atk = 0; atk < t.size(); atk++) t[atk] = uint16_t(isqrt(atk) * 3 + atk % 7);
+    return t;
+}
+// 同一個函式：用在 constexpr 變數上 -> 編譯器在編譯期算；在執行期呼叫 -> 啟動時算
+constexpr auto exp_table = make_exp_table();
+constexpr auto damage_table = make_damage_table();
+static_assert(exp_table[1] == 150 && damage_table[100] == 32);
+
+// constexpr 建構子：CH3 的寵物也可以在編譯期出生 (帽子改成編號，不用 malloc)
+class pet_template {
+public:
+    const char *name;
+    int hp;
+    int hat;
+    constexpr pet_template(const char *n, int h, int hat_id) : name(n), hp(h), hat(hat_id) {}
+};
+constexpr pet_template pet_templates[] = {{"小黑", 100, 1}, {"小白", 80, 2}, {"旺財", 120, 0}, {"咪咪", 60, 3}};
+
+// constinit：編譯期初始化，但之後可以改 (例如讀設定檔覆蓋)
+class server_config {
+public:
+    int port;
+    int max_players;
+    constexpr server_config(int p, int m) : port(p), max_players(m) {}
+};
+constinit server_config config{8080, 64};
+
+// ---- 各章的物件 ----
+class pet {
+public:
+    int hp;
+    int hat;
+    char name[16];
+};
+class bankaccount {
+public:
+    string owner;
+    int balance;
+};
+
+// 真正需要時間建立的子系統
+vector<pet> build_pets(size_t n) {
+    vector<pet> v(n);
+    for (size_t i = 0; i < n; i++) {
+        const pet_template &t = pet_templates[i % size(pet_templates)];
+        v[i].hp = t.hp;
+        v[i].hat = t.hat;
+        strncpy(v[i].name, t.name, sizeof(v[i].name) - 1);
+        v[i].name[sizeof(v[i].name) - 1] = '\0';
+    }
+    return v;
+}
+vector<bankaccount> build_accounts(size_t n) {
+    vector<bankaccount> v;
+    v.reserve(n);
+    for (size_t i = 0; i < n; i++) v.push_back({"customer_number_" + to_string(i), int(i % 1000)});
+    return v;
+}
+vector<int> build_leaderboard(size_t n) {
+    vector<int> v(n);
+    uint32_t x = 12345;
+    for (int &s : v) s = (x = x * 1103515245 + 12345) >> 8;
+    sort(v.begin(), v.end(), greater<int>());
+    return v;
+}
+
+// 第一個請求：查經驗值表、傷害表、一隻寵物
+long first_request(const long *exp, const uint16_t *dmg, const vector<pet> &pets) {
+    return exp[50] + dmg[40000] + pets[123456].hp;
+}
+
+const size_t n_pets = 2000000, n_accounts = 1000000, n_scores = 2000000;
+
+// 之前：啟動時把全部的東西都建好
+long start_before() {
+    vector<long> exp;
+    vector<uint16_t> dmg;
+    {
+        startup_profiler::scope s("經驗值表 (執行期計算)");
+        auto t = make_exp_table();
+        exp.assign(t.begin(), t.end());
+    }
+    {
+        startup_profiler::scope s("傷害表 (執行期計算)");
+        auto t = make_damage_table();
+        dmg.assign(t.begin(), t.end());
+    }
+    vector<pet> pets;
+    vector<bankaccount> accounts;
+    vector<int> scores;
+    {
+        startup_profiler::scope s("寵物名冊");
+        pets = build_pets(n_pets);
+    }
+    {
+        startup_profiler::scope s("銀行帳戶");
+        accounts = build_accounts(n_accounts);
+    }
+    {
+        startup_profiler::scope s("排行榜");
+        scores = build_leaderboard(n_scores);
+    }
+    return first_request(exp.data(), dmg.data(), pets);
+}
+
+// 之後：表格是編譯期常數，子系統都是 lazy，第一個請求只會建它需要的
+lazy<vector<pet>> pets_lazy("寵物名冊", [] { return build_pets(n_pets); });
+lazy<vector<bankaccount>> accounts_lazy("銀行帳戶", [] { return build_accounts(n_accounts); });
+lazy<vector<int>> scores_lazy("排行榜", [] { return build_leaderboard(n_scores); });
+
+long start_after() {
+    return first_request(exp_table.data(), damage_table.data(), pets_lazy.get());
+}
+
+int main(int argc, char **argv) {
+    // 子程式模式：啟動 -> 處理第一個請求 -> 結束
+    if (argc > 1 && (strcmp(argv[1], "before") == 0 || strcmp(argv[1], "after") == 0)) {
+        bool before = strcmp(argv[1], "before") == 0;
+        long answer = before ? start_before() : start_after();
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - process_start).count();
+        if (argc > 2) {
+            startup_profiler::get().report(argv[1]);
+            cout << "  第一個請求的答案 " << answer << "，從程式開始算 " << ms << " ms" << endl;
+            if (!before) {
+                cout << "  沒用到的子系統: 銀行帳戶" << (accounts_lazy.ready() ? " (已建)" : " (沒建)")
+                     << "，排行榜" << (scores_lazy.ready() ? " (已建)" : " (沒建)") << endl;
+            }
+        }
+        return answer == 0 ? 1 : 0;
+    }
+
+    cout << "設定: port " << config.port << "，最多 " << config.max_players << " 人 (constinit)" << endl;
+    config.max_players = 128;  // constinit 的變數之後還是可以改
+    cout << "寵物範本 (constexpr 建構子): ";
+    for (const auto &t : pet_templates) cout << t.name << "(hp " << t.hp << ") ";
+    cout << endl;
+
+    // 冷啟動：fork + exec 自己，量「開新程式 -> 第一個請求完成 -> 結束」的時間
+    auto cold_start = [&](const char *mode, bool verbose) {
+        auto t0 = chrono::steady_clock::now();
+        pid_t pid = fork();
+        if (pid == 0) {
+            const char *args[] = {"/proc/self/exe", mode, verbose ? "v" : nullptr, nullptr};
+            execv(args[0], (char**)args);
+            _exit(127);
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) cout << mode << " 子程式失敗!" << endl;
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+    };
+    cout.flush();
+    cold_start("before", true);
+    cout.flush();
+    cold_start("after", true);
+    cout.flush();
+
+    const int runs = 5;
+    double before = 0, after = 0;
+    for (int i = 0; i < runs; i++) {
+        before += cold_start("before", false);
+        after += cold_start("after", false);
+    }
+    cout << "冷啟動平均 (" << runs << " 次): 之前 " << before / runs << " ms，之後 " << after / runs << " ms" << endl;
+    return 0;
+}
+// 重點筆記：
+// 1. 算得出來的表就在編譯期算：constexpr 函式 + constexpr 變數，啟動成本是 0，還能用 static_assert 檢查。
+// 2. constexpr 建構子讓物件在編譯期誕生；constinit 保證全域變數不會有初始化順序的問題。
+// 3. 不一定用得到的子系統用 lazy<T>：第一次 get() 才建，call_once 保證多執行緒也只建一次。
+// 4. 先量再優化：啟動計時器會告訴你哪一步最慢；冷啟動要開新的程式來量，才算得到全域變數的初始化。
@@ -33,7 +33,7 @@ public:
     string name;
     // 【建構子】：出生時執行
     player(string n) {
-        name = n;
+        name = move(n);  // 把參數 n 的內容「搬」進來，不用再複製一份 (move 見 CH8)
         cout << ">>玩家 " << name << " 上線了" << endl;
     }
     // 【解構子】：死亡時執行
@@ -72,3 +72,701 @@ int main() {
 // 配對原則：
 // 有 new 就要有 delete。
 // 有 new [] (陣列) 就要有 delete []。
+
+
+// 補充 : 物件池 (Object Pool) —— 上線下線太頻繁的時候
+// 上面的範例一次只有一個玩家上線，new / delete 怎麼用都不痛。
+// 但真正的伺服器每秒有上萬個玩家登入、登出，每次都去 Heap 找地、還地：
+// a. 配置器 (malloc) 本身有成本 (找空位、加鎖、更新管理資料)。
+// b. 大小不一的物件來來去去，Heap 會變得坑坑洞洞 (記憶體碎片化)。
+// 解決方法：玩家下線時「只拆人，不還地」。
+// 把那塊空地記在一張「空位清單 (free list)」上，下一個玩家上線時直接蓋在同一塊地上。
+// 這正好就是 new / delete 的「二步曲」拆開來用：
+// 分配空間 -> 自己管 (從池子拿)；呼叫建構子 -> placement new：new (地址) player(...)
+// 呼叫解構子 -> 手動 p->~player()；釋放空間 -> 自己管 (放回池子)
+
+// 程式碼範例：object_pool<player>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <new>       // placement new
+#include <cstddef>
+using namespace std;
+class player {
+public:
+    string name;
+    int hp = 100;
+    // 壓力測試用，所以建構 / 解構時不印字
+    player(string n) : name(move(n)) {}
+    ~player() {}
+
+    void attack() {
+        cout << name << " 揮了一劍！" << endl;
+    }
+};
+
+template <typename T>
+class object_pool {
+private:
+    // 一格 (slot)：沒人住的時候拿來當鏈結串列的 next，有人住的時候就是 T 的空間
+    union slot {
+        slot *next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+    vector<unique_ptr<slot[]>> chunks;  // 一次向系統要一大塊 (chunk)，池子死掉時才一起還
+    size_t chunk_size;
+    size_t used_in_chunk = 0;           // 最新那塊 chunk 已經切出去幾格
+    slot *free_list = nullptr;          // 被回收、可以重複使用的格子
+
+    size_t live = 0, peak = 0, acquired = 0, reused = 0;
+
+    slot *grab() {
+        if (free_list != nullptr) {     // 優先重複使用 (in-place reuse)
+            slot *s = free_list;
+            free_list = s->next;
+            reused++;
+            return s;
+        }
+        if (chunks.empty() || used_in_chunk == chunk_size) {
+            chunks.push_back(make_unique<slot[]>(chunk_size));
+            used_in_chunk = 0;
+        }
+        return &chunks.back()[used_in_chunk++];
+    }
+    void give_back(slot *s) {
+        s->next = free_list;
+        free_list = s;
+    }
+
+public:
+    // 自訂刪除器：unique_ptr 死掉時不要 delete，而是還給池子
+    struct deleter {
+        object_pool *pool;
+        void operator()(T *p) const {
+            pool->destroy(p);
+        }
+    };
+    using handle = unique_ptr<T, deleter>;
+
+    explicit object_pool(size_t chunk = 1024) : chunk_size(chunk) {}
+    // 池子必須比它發出去的所有 handle 活得久
+    ~object_pool() {
+        if (live != 0) cerr << "object_pool: 還有 " << live << " 個物件沒還就要關池子了！" << endl;
+    }
+    object_pool(const object_pool&) = delete;
+    object_pool& operator=(const object_pool&) = delete;
+
+    // 相當於 make_unique：拿一格，用 placement new 在上面呼叫建構子
+    template <typename... Args>
+    handle make(Args&&... args) {
+        slot *s = grab();
+        T *p;
+        try {
+            p = new (s->storage) T(std::forward<Args>(args)...);
+        }
+        catch (...) {
+            give_back(s);  // 建構子丟出異常：格子還回去，物件根本沒出生
+            throw;
+        }
+        acquired++;
+        live++;
+        if (live > peak) peak = live;
+        return handle(p, deleter{this});
+    }
+    // 相當於 delete：手動呼叫解構子，然後把格子放回空位清單
+    void destroy(T *p) {
+        p->~T();
+        give_back(reinterpret_cast<slot*>(p));
+        live--;
+    }
+
+    size_t live_count() const { return live; }
+    size_t peak_count() const { return peak; }
+    // 重複使用率：有多少次建立是蓋在舊地上的
+    double reuse_rate() const { return acquired == 0 ? 0.0 : (double)reused / acquired; }
+};
+
+// 壓力測試：維持 window 個玩家同時在線，每一輪「最舊的下線、新的上線」
+template <typename Make>
+double churn(const char *label, size_t window, size_t rounds, Make make) {
+    using ptr = decltype(make(string()));
+    vector<ptr> online(window);
+    auto t0 = chrono::steady_clock::now();
+    for (size_t i = 0; i < rounds; i++) {
+        ptr &seat = online[i % window];
+        seat = make("Justin");   // 舊的那個自動下線 (解構)，新的上線
+        seat->hp -= (int)(i & 7);
+    }
+    online.clear();
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count() / rounds;
+    cout << label << ": 每次上線+下線 " << ns << " ns" << endl;
+    return ns;
+}
+
+int main() {
+    const size_t window = 10000, rounds = 5000000;
+
+    // 1. 最傳統的 new / delete (用 unique_ptr 包起來只是為了自動 delete，成本一樣)
+    //    jemalloc 的對照組：同一支程式用 LD_PRELOAD=libjemalloc.so ./a.out 執行，這一行量到的就是 jemalloc
+    churn("new/delete   ", window, rounds, [](string n) { return unique_ptr<player>(new player(move(n))); });
+    // 2. make_unique：安全的寫法，但底下一樣是 new / delete
+    churn("make_unique  ", window, rounds, [](string n) { return make_unique<player>(move(n)); });
+    // 3. 物件池
+    object_pool<player> pool;
+    churn("object_pool  ", window, rounds, [&](string n) { return pool.make(move(n)); });
+
+    cout << "池子統計: 目前在線 " << pool.live_count() << ", 最高同時在線 " << pool.peak_count()
+         << ", 重複使用率 " << pool.reuse_rate() * 100 << "%" << endl;
+
+    // 用起來跟 unique_ptr 一模一樣
+    {
+        auto p1 = pool.make("Kirito");
+        p1->attack();
+    }   // 離開大括號 -> 解構子被呼叫 -> 格子回到池子 (不是還給作業系統)
+    return 0;
+}
+// 重點筆記：
+// 1. placement new (new (地址) T(...)) 只做「建構」，不配置記憶體；對應的收尾是手動呼叫解構子 p->~T()。
+// 2. 自訂刪除器讓 unique_ptr 也能管理池子裡的物件：RAII 照用，只是「還地」的方式換掉了。
+// 3. 池子裡的格子大小固定、連續排列，不會把 Heap 切得坑坑洞洞，重複使用的格子也還在快取裡。
+// 4. 池子要比所有 handle 活得久；這個版本不是 thread-safe 的，一個執行緒 (或一個分片) 一個池子。
+
+
+// 補充 : 幾十萬個玩家同時在線 (C++20 協程 Coroutine)
+// 上面的「遊戲伺服器」在 main 裡一行一行同步執行：登入 -> 攻擊 -> 登出。
+// 真正的伺服器同時有幾十萬個玩家，每個人的動作都在「等」：等資料庫、等網路封包、等技能冷卻。
+// 如果一個玩家開一條執行緒 (thread)，每條執行緒光堆疊 (stack) 就要 8MB，幾十萬條根本開不起來。
+// 協程 (coroutine) 是「可以暫停的函式」：
+// a. 遇到 co_await 就把自己暫停，把執行緒讓給別人；等的東西好了，再從暫停的地方繼續。
+// b. 暫停時只需要保存「協程框架 (coroutine frame)」：區域變數 + 停在哪裡，通常只有幾百 bytes。
+// c. 寫起來還是由上往下的直線程式碼 (co_await login(); co_await attack(); ...)，不用拆成一堆 callback。
+// 這跟 CH4 的 new / delete 直接相關：每個協程框架都是一次 new，
+// 所以我們替框架準備一個「框架記憶體池」，暫停、結束、再開新的協程時都不用去找 malloc。
+
+// 這個小型執行環境 (runtime) 包含：
+// task<T>：會回傳 T 的協程，co_await 它就會等它做完並拿到結果。
+// executor：多執行緒的工作佇列，負責「繼續執行」被喚醒的協程。
+// reactor：用 Linux 的 epoll 等待計時器到期和檔案描述子 (fd) 可讀，時間到了就把協程丟回 executor。
+
+// 程式碼範例：
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <queue>
+#include <optional>
+#include <utility>    // exchange, move
+#include <coroutine>
+#include <exception>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+using namespace std;
+using namespace std::chrono;
+
+// ---- 協程框架記憶體池：每個執行緒一組「依大小分類」的空位清單 ----
+class frame_pool {
+private:
+    static const size_t granule = 64, classes = 16;   // 64, 128, ... 1024 bytes 各一類，再大的交給 operator new
+    struct node {
+        node *next;
+    };
+    struct lists {
+        node *head[classes] = {};
+        ~lists() {                                    // 執行緒結束時把手上的空位還給系統
+            for (node *&h : head) {
+                while (h != nullptr) {
+                    node *n = h->next;
+                    ::operator delete(h);
+                    h = n;
+                }
+            }
+        }
+    };
+    static lists &local() {
+        thread_local lists l;
+        return l;
+    }
+public:
+    static inline atomic<bool> enabled{true};         // 關掉 = 每次都直接 operator new / delete (對照組)
+    static inline atomic<long> live_bytes{0}, peak_bytes{0};
+
+    static void *allocate(size_t n) {
+        long now = live_bytes.fetch_add(n, memory_order_relaxed) + n;
+        long peak = peak_bytes.load(memory_order_relaxed);
+        while (now > peak && !peak_bytes.compare_exchange_weak(peak, now, memory_order_relaxed)) {}
+        size_t c = (n + granule - 1) / granule;
+        if (c > classes) return ::operator new(n);
+        // 不管有沒有開池子，區塊大小都以「類別」為準，這樣切換開關時新舊區塊混在一起也安全
+        if (!enabled.load(memory_order_relaxed)) return ::operator new(c * granule);
+        node *&h = local().head[c - 1];
+        if (h != nullptr) {
+            node *p = h;
+            h = p->next;
+            return p;
+        }
+        return ::operator new(c * granule);
+    }
+    static void deallocate(void *p, size_t n) {
+        live_bytes.fetch_sub(n, memory_order_relaxed);
+        size_t c = (n + granule - 1) / granule;
+        if (c > classes || !enabled.load(memory_order_relaxed)) return ::operator delete(p);
+        node *x = static_cast<node*>(p);              // 放回「目前這個執行緒」的清單
+        x->next = local().head[c - 1];
+        local().head[c - 1] = x;
+    }
+};
+
+// ---- task<T> ----
+template <typename T = void> class task;
+
+struct promise_common {
+    coroutine_handle<> continuation = noop_coroutine();  // 做完之後要叫醒誰
+    exception_ptr error;
+    atomic<bool> handoff{false};  // 「等的人已經暫停」和「我已經做完」誰先到？後到的負責叫醒等的人
+
+    suspend_always initial_suspend() noexcept { return {}; }  // 建立時先不跑，等人 co_await 才開始 (lazy)
+    struct final_awaiter {
+        bool await_ready() noexcept { return false; }
+        template <typename P>
+        coroutine_handle<> await_suspend(coroutine_handle<P> h) noexcept {
+            promise_common &p = h.promise();
+            if (p.handoff.exchange(true, memory_order_acq_rel)) return p.continuation;  // 對稱轉移：直接跳回等我的人
+            return noop_coroutine();  // 等的人還在 await_suspend 裡，它會自己繼續 (不會越疊越深)
+        }
+        void await_resume() noexcept {}
+    };
+    final_awaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() { error = current_exception(); }  // 例外存起來，co_await 的人會收到
+
+    // 協程框架的 new / delete 改走記憶體池
+    static void *operator new(size_t n) { return frame_pool::allocate(n); }
+    static void operator delete(void *p, size_t n) { frame_pool::deallocate(p, n); }
+};
+template <typename T>
+struct task_promise : promise_common {
+    optional<T> value;
+    task<T> get_return_object();
+    void return_value(T v) { value = move(v); }
+};
+template <>
+struct task_promise<void> : promise_common {
+    task<void> get_return_object();
+    void return_void() {}
+};
+
+template <typename T>
+class task {
+private:
+    coroutine_handle<task_promise<T>> h;
+public:
+    using promise_type = task_promise<T>;
+    explicit task(coroutine_handle<promise_type> handle) : h(handle) {}
+    task(task &&o) noexcept : h(exchange(o.h, nullptr)) {}
+    task(const task&) = delete;
+    ~task() {
+        if (h) h.destroy();
+    }
+    // co_await 一個 task：記下「我在等你」，然後直接開始跑它
+    // 如果它一路跑完都沒暫停 (同步完成)，就不用暫停自己，直接拿結果，呼叫堆疊也不會一直疊上去
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(coroutine_handle<> caller) noexcept {
+        h.promise().continuation = caller;
+        h.resume();
+        return !h.promise().handoff.exchange(true, memory_order_acq_rel);
+    }
+    T await_resume() {
+        if (h.promise().error) rethrow_exception(h.promise().error);
+        if constexpr (!is_void_v<T>) return move(*h.promise().value);
+    }
+};
+template <typename T>
+task<T> task_promise<T>::get_return_object() { return task<T>(coroutine_handle<task_promise<T>>::from_promise(*this)); }
+inline task<void> task_promise<void>::get_return_object() { return task<void>(coroutine_handle<task_promise<void>>::from_promise(*this)); }
+
+// ---- executor + reactor ----
+class executor {
+private:
+    mutex mu;
+    condition_variable cv;
+    deque<coroutine_handle<>> ready;   // 可以繼續執行的協程
+    vector<thread> workers;
+    atomic<bool> stopping{false};
+
+    // reactor：epoll 同時等「計時器」和「fd 可讀」
+    struct timer {
+        steady_clock::time_point when;
+        uint64_t seq;
+        coroutine_handle<> h;
+        bool operator>(const timer &o) const { return when != o.when ? when > o.when : seq > o.seq; }
+    };
+    int ep, wakefd;
+    mutex timer_mu;
+    priority_queue<timer, vector<timer>, greater<timer>> timers;
+    uint64_t timer_seq = 0;
+    thread reactor;
+
+    atomic<long> outstanding{0};       // 還沒結束的 spawn 任務
+    mutex idle_mu;
+    condition_variable idle_cv;
+
+    void work() {
+        unique_lock<mutex> lk(mu);
+        while (true) {
+            cv.wait(lk, [&] { return stopping || !ready.empty(); });
+            if (ready.empty()) return;
+            coroutine_handle<> h = ready.front();
+            ready.pop_front();
+            lk.unlock();
+            h.resume();                // 從上次暫停的地方繼續跑，直到下一個 co_await
+            lk.lock();
+        }
+    }
+    void wake_reactor() {
+        uint64_t one = 1;
+        (void)!::write(wakefd, &one, sizeof(one));
+    }
+    void react() {
+        epoll_event events[64];
+        while (true) {
+            int timeout = -1;
+            if (stopping) return;
+            {
+                lock_guard<mutex> lk(timer_mu);
+                if (!timers.empty()) {
+                    auto wait = ceil<milliseconds>(timers.top().when - steady_clock::now()).count();
+                    timeout = (int)max<long long>(wait, 0);
+                }
+            }
+            int n = epoll_wait(ep, events, 64, timeout);
+            for (int i = 0; i < n; i++) {
+                if (events[i].data.ptr == nullptr) {   // 有人叫醒 reactor (新的計時器或要關機)
+                    uint64_t v;
+                    (void)!::read(wakefd, &v, sizeof(v));
+                }
+                else {
+                    post(coroutine_handle<>::from_address(events[i].data.ptr));
+                }
+            }
+            // 到期的計時器先拿出來，放開 timer_mu 之後才 post (不要同時抱著兩把鎖)
+            vector<coroutine_handle<>> due;
+            {
+                auto now = steady_clock::now();
+                lock_guard<mutex> lk(timer_mu);
+                while (!timers.empty() && timers.top().when <= now) {
+                    due.push_back(timers.top().h);
+                    timers.pop();
+                }
+            }
+            for (auto h : due) post(h);
+        }
+    }
+    friend void task_finished(executor &ex);
+
+public:
+    explicit executor(int threads = (int)max(1u, thread::hardware_concurrency())) {
+        ep = epoll_create1(0);
+        wakefd = eventfd(0, EFD_NONBLOCK);
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.ptr = nullptr;
+        epoll_ctl(ep, EPOLL_CTL_ADD, wakefd, &ev);
+        for (int i = 0; i < threads; i++) workers.emplace_back(&executor::work, this);
+        reactor = thread(&executor::react, this);
+    }
+    ~executor() {
+        {
+            lock_guard<mutex> lk(mu);
+            stopping = true;
+        }
+        cv.notify_all();
+        wake_reactor();
+        for (auto &w : workers) w.join();
+        reactor.join();
+        close(wakefd);
+        close(ep);
+    }
+    void post(coroutine_handle<> h) {
+        {
+            lock_guard<mutex> lk(mu);
+            ready.push_back(h);
+        }
+        cv.notify_one();
+    }
+
+    // co_await ex.schedule()：換到 executor 的執行緒上 (也可以當作「讓出執行緒」yield)
+    auto schedule() {
+        struct awaiter {
+            executor *ex;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(coroutine_handle<> h) { ex->post(h); }
+            void await_resume() const noexcept {}
+        };
+        return awaiter{this};
+    }
+    // co_await ex.sleep_for(10ms)：暫停，時間到了再繼續 (執行緒不會被佔住)
+    auto sleep_for(steady_clock::duration d) {
+        struct awaiter {
+            executor *ex;
+            steady_clock::time_point when;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(coroutine_handle<> h) {
+                // 放進計時器之後，協程隨時可能在別的執行緒被繼續、甚至結束 (連這個 awaiter 都不見了)，
+                // 所以之後只能用區域變數，不能再碰 this
+                executor *e = ex;
+                bool earliest;
+                {
+                    lock_guard<mutex> lk(e->timer_mu);
+                    e->timers.push({when, e->timer_seq++, h});
+                    earliest = e->timers.top().h == h;
+                }
+                if (earliest) e->wake_reactor();  // 比 reactor 正在等的時間還早，叫它重新算
+            }
+            void await_resume() const noexcept {}
+        };
+        return awaiter{this, steady_clock::now() + d};
+    }
+    // co_await ex.readable(fd)：等到 fd 有資料可以讀
+    auto readable(int fd) {
+        struct awaiter {
+            executor *ex;
+            int fd;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(coroutine_handle<> h) {
+                epoll_event ev{};
+                ev.events = EPOLLIN | EPOLLONESHOT;   // 只通知一次，下次要等再重新登記
+                ev.data.ptr = h.address();
+                if (epoll_ctl(ex->ep, EPOLL_CTL_ADD, fd, &ev) != 0) epoll_ctl(ex->ep, EPOLL_CTL_MOD, fd, &ev);
+            }
+            void await_resume() const noexcept {}
+        };
+        return awaiter{this, fd};
+    }
+    // 等所有 spawn 出去的任務都結束
+    void wait_idle() {
+        unique_lock<mutex> lk(idle_mu);
+        idle_cv.wait(lk, [&] { return outstanding.load() == 0; });
+    }
+    void task_started() { outstanding++; }
+};
+void task_finished(executor &ex) {
+    if (--ex.outstanding == 0) {
+        lock_guard<mutex> lk(ex.idle_mu);
+        ex.idle_cv.notify_all();
+    }
+}
+
+// 「放出去就不管」的協程：一開始就跑，結束時自己把框架收掉
+struct detached {
+    struct promise_type {
+        detached get_return_object() { return {}; }
+        suspend_never initial_suspend() noexcept { return {}; }
+        suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { terminate(); }
+        static void *operator new(size_t n) { return frame_pool::allocate(n); }
+        static void operator delete(void *p, size_t n) { frame_pool::deallocate(p, n); }
+    };
+};
+detached run_detached(executor &ex, task<void> t) {
+    co_await ex.schedule();   // 換到 executor 的執行緒上跑
+    try {
+        co_await t;
+    }
+    catch (const exception &e) {
+        cerr << "任務丟出例外: " << e.what() << endl;
+    }
+    catch (...) {             // throw 的不一定是 exception (例如 throw 42)，漏接的話整個伺服器會 terminate
+        cerr << "任務丟出不明的例外" << endl;
+    }
+    task_finished(ex);
+}
+void spawn(executor &ex, task<void> t) {
+    ex.task_started();
+    run_detached(ex, move(t));
+}
+
+// 在一般的函式 (例如 main) 裡等一個 task 做完
+// 只等「這一個」task：不能用 wait_idle，不然有個一直在等封包的伺服器任務，這裡就永遠回不來。
+// 協程設好 done 之後還會跑完剩下的部分 (解鎖、收掉框架)，所以共用的狀態放在 shared_ptr 裡，
+// 由協程框架和呼叫的人一起持有，呼叫的人看到 done 就可以直接離開。
+template <typename T>
+struct sync_wait_state {
+    mutex m;
+    condition_variable cv;
+    bool done = false;
+    exception_ptr error;
+    optional<T> result;
+};
+template <>
+struct sync_wait_state<void> {   // void 沒有結果可以存 (optional<void> 是不合法的)
+    mutex m;
+    condition_variable cv;
+    bool done = false;
+    exception_ptr error;
+};
+template <typename T>
+detached sync_wait_body(executor &ex, task<T> t, shared_ptr<sync_wait_state<T>> st) {
+    co_await ex.schedule();
+    try {
+        if constexpr (is_void_v<T>) co_await t;
+        else st->result.emplace(co_await t);
+    }
+    catch (...) {
+        st->error = current_exception();
+    }
+    {
+        lock_guard<mutex> lk(st->m);
+        st->done = true;
+    }
+    st->cv.notify_one();
+}
+template <typename T>
+T sync_wait(executor &ex, task<T> t) {
+    auto st = make_shared<sync_wait_state<T>>();
+    sync_wait_body(ex, move(t), st);
+    unique_lock<mutex> lk(st->m);
+    st->cv.wait(lk, [&] { return st->done; });
+    if (st->error) rethrow_exception(st->error);
+    if constexpr (!is_void_v<T>) return move(*st->result);
+}
+
+// ---- 玩家的非同步流程：看起來跟同步程式一模一樣 ----
+class player {
+public:
+    string name;
+    int damage = 0;
+    player(string n) : name(move(n)) {}
+};
+task<void> login(executor &ex, player &p, bool verbose) {
+    co_await ex.sleep_for(5ms);        // 模擬去資料庫查帳號
+    if (verbose) cout << ">>玩家 " << p.name << " 上線了" << endl;
+}
+task<int> attack(executor &ex, player &p, bool verbose) {
+    co_await ex.sleep_for(2ms);        // 技能冷卻
+    if (verbose) cout << p.name << " 揮了一劍！" << endl;
+    co_return 10;
+}
+task<void> logout(executor &ex, player &p, bool verbose) {
+    co_await ex.sleep_for(1ms);        // 存檔
+    if (verbose) cout << ">>玩家 " << p.name << " 下線了 (總傷害 " << p.damage << ")" << endl;
+}
+task<void> session(executor &ex, string name, bool verbose) {
+    player p(move(name));              // 活在協程框架裡，協程結束時自動解構
+    co_await login(ex, p, verbose);
+    for (int i = 0; i < 3; i++) p.damage += co_await attack(ex, p, verbose);
+    co_await logout(ex, p, verbose);
+}
+
+// 等 fd 的例子：登入伺服器用 pipe 收「登入封包」，每個封包以 '\n' 結尾
+// 一次 read() 可能讀到半個封包，也可能一次讀到好幾個，所以要自己從緩衝區切出完整的封包來數
+task<void> login_server(executor &ex, int fd, int expected) {
+    char buf[64];
+    string pending;                    // 還沒湊滿一個封包的部分
+    for (int got = 0; got < expected; ) {
+        co_await ex.readable(fd);      // 沒有封包就暫停，不佔執行緒
+        ssize_t n = ::read(fd, buf, sizeof(buf));
+        if (n == 0) {                  // 對方關掉了 (EOF)：不會再有封包，繼續等只會空轉
+            cout << "登入伺服器：連線關閉，收到 " << got << " 個封包" << endl;
+            co_return;
+        }
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) continue;   // 暫時沒資料，再等一次
+            cerr << "登入伺服器讀取失敗: " << strerror(errno) << endl;
+            co_return;
+        }
+        pending.append(buf, n);
+        size_t end;
+        while ((end = pending.find('\n')) != string::npos) {
+            cout << "登入伺服器收到封包: " << pending.substr(0, end) << endl;
+            pending.erase(0, end + 1);
+            got++;
+        }
+    }
+}
+task<void> client(executor &ex, int fd, string packets, milliseconds delay) {
+    co_await ex.sleep_for(delay);
+    (void)!::write(fd, packets.data(), packets.size());
+}
+
+// ---- 效能量測 ----
+task<int> tiny(int x) { co_return x + 1; }
+task<long> frame_churn(int n) {
+    long s = 0;
+    for (int i = 0; i < n; i++) s += co_await tiny(i);   // 每一次都建立 + 銷毀一個協程框架
+    co_return s;
+}
+task<long> ping(executor &ex, int n) {
+    for (int i = 0; i < n; i++) co_await ex.schedule();  // 暫停 -> 進佇列 -> 被取出 -> 繼續
+    co_return n;
+}
+template <typename F>
+double ns_per(int n, F f) {
+    auto t0 = steady_clock::now();
+    f();
+    return duration<double, nano>(steady_clock::now() - t0).count() / n;
+}
+
+int main(int argc, char **argv) {
+    // 用法: ./a.out [同時在線的玩家數]
+    int sessions = argc > 1 ? stoi(argv[1]) : 200000;
+    executor ex;
+
+    // 1. 三個玩家的故事 (互相穿插執行)
+    cout << "--- 遊戲伺服器啟動 ---" << endl;
+    for (string n : {"Justin", "Kirito", "Asuna"}) spawn(ex, session(ex, n, true));
+    ex.wait_idle();
+
+    // 2. 等 fd 可讀
+    int fds[2];
+    if (pipe(fds) != 0) return 1;
+    spawn(ex, login_server(ex, fds[0], 4));
+    spawn(ex, client(ex, fds[1], "LOGIN Justin\n", 10ms));
+    spawn(ex, client(ex, fds[1], "LOGIN Kirito\n", 20ms));
+    spawn(ex, client(ex, fds[1], "LOGIN Asuna\nLOGIN Klein\n", 30ms));  // 兩個封包一次寫進去
+    // 登入伺服器還在等封包，sync_wait 只等自己的 task，不會被它卡住
+    cout << "sync_wait(tiny(41)) = " << sync_wait(ex, tiny(41)) << endl;
+    ex.wait_idle();
+    close(fds[0]);
+    close(fds[1]);
+    cout << "--- 遊戲伺服器關閉 ---" << endl;
+
+    // 3. 協程框架配置：記憶體池 vs operator new
+    const int n = 2000000;
+    for (bool pooled : {false, true}) {
+        frame_pool::enabled = pooled;
+        double ns = ns_per(n, [&] { sync_wait(ex, frame_churn(n)); });
+        cout << "建立+銷毀一個協程 (" << (pooled ? "記憶體池" : "operator new") << "): " << ns << " ns" << endl;
+    }
+
+    // 4. 切換成本：暫停再被 executor 繼續
+    cout << "一次 co_await schedule() 的來回: " << ns_per(n, [&] { sync_wait(ex, ping(ex, n)); }) << " ns" << endl;
+
+    // 5. 大量同時在線：每個玩家都有登入、三次攻擊、登出，全部穿插在少數幾條執行緒上
+    frame_pool::peak_bytes = frame_pool::live_bytes.load();
+    auto t0 = steady_clock::now();
+    for (int i = 0; i < sessions; i++) spawn(ex, session(ex, "player" + to_string(i), false));
+    ex.wait_idle();
+    cout << sessions << " 個玩家同時在線，全部跑完花了 " << duration<double, milli>(steady_clock::now() - t0).count()
+         << " ms，協程框架最高用了 " << frame_pool::peak_bytes / 1024 / 1024 << " MB (每位玩家約 "
+         << frame_pool::peak_bytes / sessions << " bytes)" << endl;
+    return 0;
+}
+// 重點筆記：
+// 1. co_await = 「我先暫停，東西好了再叫我」，執行緒不會被卡住，所以少少幾條執行緒就能服務幾十萬個玩家。
+// 2. 協程框架就是一塊 new 出來的記憶體：替 promise_type 寫 operator new / delete，就能接上記憶體池。
+// 3. task 是 lazy 的：建立時不跑，被 co_await 才開始；中途暫停過的 task 做完時用「對稱轉移」直接跳回等它的人，
+//    沒暫停就做完的 task 則讓等的人直接往下跑，呼叫堆疊不會越疊越深。
+// 4. 例外一樣可以用：協程裡 throw 的東西會被存起來，在 co_await 的地方重新丟出 (跟 CH11 一樣 try/catch)。
+// 5. 讀 fd 要處理三種結果：有資料 (可能不只一個封包)、0 = 對方關閉、-1 = 錯誤 (EAGAIN 才是「再等一下」)。
@@ -32,7 +32,7 @@ public:
     int hp;
 
     character(string n) {
-        name = n;
+        name = move(n);  // 搬進來，不是複製
         hp = 100;  // 預設血量
     }
     void eat() {
@@ -47,7 +47,7 @@ public:
     // 建構子 
     // 在建立戰士 (Warrior) 之前，先用參數 n 把裡面的角色 (Character) 初始化好。
     // 這就是所謂的「委派父類別建構子」
-    warrior(string n) : character(n) {
+    warrior(string n) : character(move(n)) {
         // 這裡可以做戰士特別的初始化 (如果沒有也不能省略，因為出生時要給名字)
     }
 
@@ -59,7 +59,7 @@ public:
 // 【子類別】：法師 (繼承自 Character)
 class wizard : public character {
 public:
-    wizard(string n) : character(n) {
+    wizard(string n) : character(move(n)) {
         // 這裡可以做巫師特別的初始化
     }
 
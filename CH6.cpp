@@ -31,7 +31,7 @@ class Character {
 public:
     string name;
 
-    Character(string n) : name(n) {}
+    Character(string n) : name(move(n)) {}
 
     // 【關鍵點】：加上 virtual
     // 這代表允許子類別「覆寫 (Override)」這個函式
@@ -41,7 +41,7 @@ public:
 };
 class Warrior : public Character {
 public:
-    Warrior(string n) : Character(n) {}  // 繼承專屬的語法
+    Warrior(string n) : Character(move(n)) {}  // 繼承專屬的語法
 
     //【覆寫】：這裡是戰士的版本
     // override 關鍵字是 C++11 加的，雖非強制但強烈建議加上，
@@ -52,7 +52,7 @@ public:
 };
 class Wizard : public Character {
 public:
-    Wizard(string n) : Character(n) {}
+    Wizard(string n) : Character(move(n)) {}
 
     void attack() override {
         cout << name << " 唱出了大火球！" << endl;
@@ -114,3 +114,657 @@ public:
 // B. 關鍵字 virtual：加在父類別函式前。告訴編譯器要看「物件本體」而不是「指標型別」。
 // C. 關鍵字 override：加在子類別函式後。確保你真的有覆寫成功（防呆用）。
 // D. 多型 (Polymorphism)：「一個介面，多種行為」。用同一個指標 attack()，戰士會砍、法師會燒。
+
+
+// 補充 : 大火球打到誰？ (空間索引 Spatial Index)
+// 上面的隊伍只是一個 Character* party[3]，角色也沒有「位置」。
+// 真正的遊戲地圖上有上百萬個角色，法師丟出大火球時要回答：「半徑 50 公尺內有誰？」
+// 笨方法 (暴力掃描)：把一百萬個角色全部看一遍，算距離。一顆火球就要掃一百萬次，一幀有幾千顆火球就完蛋了。
+// 聰明方法：把地圖切成格子 (像圍棋棋盤)，每個格子記住「誰站在我這裡」。
+// 查詢時只看火球碰得到的那幾格，其他幾十萬格連看都不用看。
+// 兩種切法：
+// a. 均勻網格 (Uniform Grid)：格子大小都一樣，最簡單也最快，適合大家體型差不多的情況。
+// b. 寬鬆四元樹 (Loose Quadtree)：一層一層越切越細，小怪放細的格子，巨龍放粗的格子；
+//    「寬鬆」的意思是每一格的邊界往外多算半格，角色只要中心點在格子裡就放得進去，移動時很少需要換格。
+// 角色移動時不用重建整個索引：同一格就原地改座標，換格才從舊格移到新格 (incremental update)。
+
+// 程式碼範例：
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+#include <stdexcept>
+using namespace std;
+struct vec2 {
+    float x, y;
+};
+struct box {
+    float minx, miny, maxx, maxy;
+};
+
+class Character {
+public:
+    string name;
+    vec2 pos;
+    float radius;  // 體型 (碰撞半徑)
+    int hp = 100;
+
+    Character(string n, vec2 p, float r = 0.5f) : name(move(n)), pos(p), radius(r) {}
+    virtual ~Character() {}
+    virtual void attack() {
+        cout << name << " 揮了一拳 (普通攻擊)" << endl;
+    }
+};
+
+// 「格子怎麼切」的兩種策略 (layout)，索引本身共用同一份程式碼
+// 1. 均勻網格：所有格子一樣大，查詢框要往外多擴「最大體型」，才不會漏掉壓線的大傢伙
+class uniform_grid {
+private:
+    float cell, max_r;
+    int dim;
+public:
+    uniform_grid(float world, float cell_size, float max_radius)
+        : cell(cell_size), max_r(max_radius), dim((int)ceil(world / cell_size)) {}
+    size_t cell_count() const { return (size_t)dim * dim; }
+    // 查詢只往外擴 max_r，比它大的角色放進去就會被漏掉，所以直接拒收
+    bool accepts(float r) const { return r <= max_r; }
+    int clampi(float v) const { return min(max((int)(v / cell), 0), dim - 1); }
+    uint32_t cell_of(vec2 p, float) const { return clampi(p.y) * dim + clampi(p.x); }
+    template <typename F>
+    void for_cells(const box &b, F f) const {
+        int x0 = clampi(b.minx - max_r), x1 = clampi(b.maxx + max_r);
+        int y0 = clampi(b.miny - max_r), y1 = clampi(b.maxy + max_r);
+        for (int y = y0; y <= y1; y++)
+            for (int x = x0; x <= x1; x++) f(y * dim + x);  // 同一列的格子在記憶體裡是連續的
+    }
+};
+// 2. 寬鬆四元樹：第 L 層切成 2^L x 2^L 格，每一格的有效範圍往外多算半格
+//    體型 r 的角色放在「半格 >= r」的最細那一層，這樣它整個身體一定在那一格的寬鬆範圍內
+class loose_quadtree {
+private:
+    float world;
+    int depth;
+    vector<uint32_t> offset;  // 每一層的第一格在整個陣列裡的位置
+public:
+    loose_quadtree(float world_size, int max_depth) : world(world_size), depth(max_depth) {
+        uint32_t total = 0;
+        for (int l = 0; l <= depth; l++) {
+            offset.push_back(total);
+            total += 1u << (2 * l);
+        }
+        offset.push_back(total);
+    }
+    size_t cell_count() const { return offset.back(); }
+    bool accepts(float) const { return true; }   // 再大的都放得進第 0 層 (整張地圖一格)
+    float cell_size(int l) const { return world / (1 << l); }
+    int clampi(float v, int l) const { return min(max((int)(v / cell_size(l)), 0), (1 << l) - 1); }
+    uint32_t cell_of(vec2 p, float r) const {
+        int l = depth;
+        while (l > 0 && cell_size(l) / 2 < r) l--;
+        return offset[l] + clampi(p.y, l) * (1u << l) + clampi(p.x, l);
+    }
+    template <typename F>
+    void for_cells(const box &b, F f) const {
+        for (int l = 0; l <= depth; l++) {
+            float loose = cell_size(l) / 2;
+            int x0 = clampi(b.minx - loose, l), x1 = clampi(b.maxx + loose, l);
+            int y0 = clampi(b.miny - loose, l), y1 = clampi(b.maxy + loose, l);
+            for (int y = y0; y <= y1; y++)
+                for (int x = x0; x <= x1; x++) f(offset[l] + y * (1u << l) + x);
+        }
+    }
+};
+
+// 空間索引：每一格是一段連續的 {id, x, y, r}，查詢時一格一格線性掃過去，對快取很友善
+template <typename Layout>
+class spatial_index {
+private:
+    struct entry {
+        uint32_t id;
+        float x, y, r;
+    };
+    struct where {
+        uint32_t cell = UINT32_MAX;
+        uint32_t slot = 0;
+    };
+    Layout layout;
+    vector<vector<entry>> cells;
+    vector<where> loc;  // loc[id]：這個角色現在在哪一格的第幾個位置
+
+    void remove_from_cell(uint32_t id) {
+        where w = loc[id];
+        vector<entry> &c = cells[w.cell];
+        c[w.slot] = c.back();         // 拿最後一個來補洞 (swap-remove)，O(1)
+        loc[c[w.slot].id].slot = w.slot;
+        c.pop_back();
+        loc[id].cell = UINT32_MAX;
+    }
+public:
+    explicit spatial_index(Layout l) : layout(move(l)), cells(layout.cell_count()) {}
+
+    void insert(uint32_t id, vec2 p, float r) {
+        if (!layout.accepts(r)) throw invalid_argument("體型 " + to_string(r) + " 超過這個網格的上限，查詢會找不到它");
+        if (id >= loc.size()) loc.resize(id + 1);
+        uint32_t c = layout.cell_of(p, r);
+        loc[id] = {c, (uint32_t)cells[c].size()};
+        cells[c].push_back({id, p.x, p.y, r});
+    }
+    void erase(uint32_t id) {
+        if (id < loc.size() && loc[id].cell != UINT32_MAX) remove_from_cell(id);
+    }
+    // 增量更新：還在同一格就原地改座標，換格才搬家
+    void move_to(uint32_t id, vec2 p) {
+        // 跟 erase 一樣先確認它真的在索引裡：沒放進來或已經刪掉的 id，loc 不是越界就是「不在任何一格」
+        if (id >= loc.size() || loc[id].cell == UINT32_MAX) throw out_of_range("角色 " + to_string(id) + " 不在索引裡");
+        where w = loc[id];
+        entry &e = cells[w.cell][w.slot];
+        uint32_t c = layout.cell_of(p, e.r);
+        if (c == w.cell) {
+            e.x = p.x;
+            e.y = p.y;
+            return;
+        }
+        float r = e.r;
+        remove_from_cell(id);
+        loc[id] = {c, (uint32_t)cells[c].size()};
+        cells[c].push_back({id, p.x, p.y, r});
+    }
+    // 圓形查詢：身體 (圓) 跟火球 (圓) 有碰到就算
+    void query_radius(vec2 center, float radius, vector<uint32_t> &out) const {
+        box b{center.x - radius, center.y - radius, center.x + radius, center.y + radius};
+        layout.for_cells(b, [&](uint32_t c) {
+            for (const entry &e : cells[c]) {
+                float dx = e.x - center.x, dy = e.y - center.y, reach = radius + e.r;
+                if (dx * dx + dy * dy <= reach * reach) out.push_back(e.id);
+            }
+        });
+    }
+    // 矩形查詢：身體 (圓) 跟矩形有重疊就算
+    void query_box(const box &b, vector<uint32_t> &out) const {
+        layout.for_cells(b, [&](uint32_t c) {
+            for (const entry &e : cells[c]) {
+                float dx = e.x - clamp(e.x, b.minx, b.maxx), dy = e.y - clamp(e.y, b.miny, b.maxy);
+                if (dx * dx + dy * dy <= e.r * e.r) out.push_back(e.id);
+            }
+        });
+    }
+    // 批次查詢：先把查詢依照位置排序，相鄰的查詢會碰到相同的格子 (還在快取裡)
+    // 結果放在 ids，第 i 個查詢的答案是 ids[ranges[i].first .. ranges[i].second)
+    void query_radius_batch(const vector<vec2> &centers, float radius,
+                            vector<uint32_t> &ids, vector<pair<uint32_t, uint32_t>> &ranges) const {
+        vector<uint32_t> order(centers.size());
+        for (uint32_t i = 0; i < order.size(); i++) order[i] = i;
+        sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return layout.cell_of(centers[a], 0) < layout.cell_of(centers[b], 0);
+        });
+        ids.clear();
+        ranges.assign(centers.size(), {0, 0});
+        for (uint32_t q : order) {
+            uint32_t begin = ids.size();
+            query_radius(centers[q], radius, ids);
+            ranges[q] = {begin, (uint32_t)ids.size()};
+        }
+    }
+};
+
+// 對照組：暴力掃描全部角色
+void brute_radius(const vector<unique_ptr<Character>> &all, vec2 center, float radius, vector<uint32_t> &out) {
+    for (uint32_t id = 0; id < all.size(); id++) {
+        const Character &c = *all[id];
+        float dx = c.pos.x - center.x, dy = c.pos.y - center.y, reach = radius + c.radius;
+        if (dx * dx + dy * dy <= reach * reach) out.push_back(id);
+    }
+}
+
+class Wizard : public Character {
+public:
+    Wizard(string n, vec2 p) : Character(move(n), p) {}
+    void attack() override {
+        cout << name << " 唱出了大火球！" << endl;
+    }
+    // 大火球：範圍內所有角色 (除了自己) 扣 30 血
+    template <typename Index>
+    int fireball(vec2 target, float radius, const Index &index, vector<unique_ptr<Character>> &all, uint32_t self) {
+        attack();
+        vector<uint32_t> hit;
+        index.query_radius(target, radius, hit);
+        int count = 0;
+        for (uint32_t id : hit) {
+            if (id == self) continue;
+            all[id]->hp -= 30;
+            count++;
+        }
+        return count;
+    }
+};
+
+const float world = 10000;
+uint32_t rng_state = 12345;
+float frand(float hi) {  // 簡單的亂數 (xorshift)
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return (rng_state % 1000000) / 1000000.0f * hi;
+}
+
+template <typename Index>
+bool same_as_brute(const Index &index, const vector<unique_ptr<Character>> &all, vec2 center, float radius) {
+    vector<uint32_t> a, b;
+    index.query_radius(center, radius, a);
+    brute_radius(all, center, radius, b);
+    sort(a.begin(), a.end());
+    return a == b;
+}
+
+template <typename Index>
+void bench(const char *label, Index &index, vector<unique_ptr<Character>> &all,
+           const vector<vec2> &targets, float radius) {
+    for (uint32_t id = 0; id < all.size(); id++) index.insert(id, all[id]->pos, all[id]->radius);
+
+    vector<uint32_t> ids;
+    vector<pair<uint32_t, uint32_t>> ranges;
+    auto t0 = chrono::steady_clock::now();
+    index.query_radius_batch(targets, radius, ids, ranges);
+    double q_us = chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count() / targets.size();
+
+    // 正確性：前 20 顆火球跟暴力掃描比對
+    bool ok = true;
+    for (size_t q = 0; q < 20; q++) {
+        vector<uint32_t> a(ids.begin() + ranges[q].first, ids.begin() + ranges[q].second), b;
+        brute_radius(all, targets[q], radius, b);
+        sort(a.begin(), a.end());
+        ok = ok && a == b;
+    }
+
+    // 每個角色走一小步 (大部分不會換格)
+    t0 = chrono::steady_clock::now();
+    for (uint32_t id = 0; id < all.size(); id++) {
+        vec2 &p = all[id]->pos;
+        p = {clamp(p.x + frand(2) - 1, 0.0f, world), clamp(p.y + frand(2) - 1, 0.0f, world)};
+        index.move_to(id, p);
+    }
+    double m_ns = chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count() / all.size();
+    for (size_t q = 20; q < 40; q++) ok = ok && same_as_brute(index, all, targets[q], radius);  // 移動之後也要對
+    cout << label << ": 每次查詢 " << q_us << " us, 每次移動 " << m_ns << " ns, 找到 " << ids.size() << " 個命中 "
+         << (ok ? "(跟暴力掃描一致)" : "(跟暴力掃描不一致!)") << endl;
+}
+
+int main(int argc, char **argv) {
+    // 用法: ./a.out [角色數]
+    size_t n = argc > 1 ? stoul(argv[1]) : 1000000;
+    const float radius = 50;
+
+    vector<unique_ptr<Character>> all;
+    for (size_t i = 0; i < n; i++) {
+        float r = i % 1000 == 0 ? 20.0f : 0.5f;  // 千分之一是巨龍，體型大很多
+        all.push_back(make_unique<Character>("怪物", vec2{frand(world), frand(world)}, r));
+    }
+    vector<vec2> targets;
+    for (int i = 0; i < 10000; i++) targets.push_back({frand(world), frand(world)});
+
+    // 暴力掃描太慢，只量 50 顆火球再平均
+    vector<uint32_t> hits;
+    auto t0 = chrono::steady_clock::now();
+    for (int q = 0; q < 50; q++) brute_radius(all, targets[q], radius, hits);
+    cout << "暴力掃描: 每次查詢 " << chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count() / 50 << " us" << endl;
+
+    spatial_index<uniform_grid> grid(uniform_grid(world, 50, 20));
+    bench("均勻網格  ", grid, all, targets, radius);
+    spatial_index<loose_quadtree> tree(loose_quadtree(world, 8));
+    bench("寬鬆四元樹", tree, all, targets, radius);
+
+    // 實戰：梅林對著人群丟大火球 (角色剛剛在四元樹那一輪移動過，所以用它來查)
+    all.push_back(make_unique<Wizard>("梅林", vec2{5000, 5000}));
+    uint32_t merlin = all.size() - 1;
+    tree.insert(merlin, all[merlin]->pos, all[merlin]->radius);
+    Wizard &w = static_cast<Wizard&>(*all[merlin]);
+    int count = w.fireball({5000, 5050}, radius, tree, all, merlin);
+    cout << "大火球燒到了 " << count << " 個角色" << endl;
+
+    // 矩形查詢：小地圖上顯示的範圍
+    vector<uint32_t> visible;
+    tree.query_box({4900, 4900, 5100, 5100}, visible);
+    cout << "小地圖範圍內有 " << visible.size() << " 個角色" << endl;
+
+    // 用錯的時候要喊出來，不要默默算錯
+    tree.erase(merlin);
+    try {
+        tree.move_to(merlin, {10, 10});   // 已經刪掉了
+    }
+    catch (const exception &e) {
+        cout << "move_to: " << e.what() << endl;
+    }
+    try {
+        grid.insert(merlin, {10, 10}, 100);   // 比網格設定的最大體型 (20) 還大
+    }
+    catch (const exception &e) {
+        cout << "insert: " << e.what() << endl;
+    }
+    return 0;
+}
+// 重點筆記：
+// 1. 空間索引的本質：「先用格子刪掉絕大多數不可能的人，再對剩下的人算距離」。
+// 2. 每一格用連續的 vector 存 {id, 座標, 體型}，查詢時掃的是連續記憶體，不用跳去看每個 Character 物件。
+// 3. 移動時大部分角色還在同一格，只要改座標；換格就 swap-remove + push_back，都是 O(1)。
+// 4. 體型差很多時用寬鬆四元樹，大傢伙放粗的層，均勻網格就不必為了牠把每次查詢都擴得很大。
+// 5. 索引的前提要在入口擋住：均勻網格拒收超過最大體型的角色，不在索引裡的 id 不能 move_to。
+
+
+// 補充 : 不用 virtual 也能多型 (編譯期技能表 + CRTP)
+// virtual 很方便，但每次 p->attack() 都要：讀 vptr -> 查虛擬函式表 -> 間接跳躍。
+// 編譯器在編譯時不知道會跳去哪裡，所以沒辦法把 attack() 內嵌 (inline) 進迴圈，也沒辦法一起最佳化。
+// 如果職業是「寫程式的時候就決定好的」(戰士、法師...)，其實可以讓編譯器在編譯期就決定：
+// 1. 技能表：傷害、耗魔、冷卻寫成 constexpr 陣列，編譯期就能檢查 (static_assert)，執行時零成本讀取。
+// 2. CRTP (Curiously Recurring Template Pattern)：class Warrior : public character_base<Warrior>
+//    父類別是樣板，知道兒子的真實型別，static_cast<Derived*>(this)->on_attack() 直接呼叫兒子的函式，
+//    不需要 virtual；兒子沒寫 on_attack 就用父類別的預設版本。
+// 3. 一個隊伍裡有不同職業時：每個職業放自己的 vector，用 fold expression 讓編譯器替每個職業產生一段迴圈，
+//    每一段都是直接呼叫，可以完全內嵌。(或是用 variant + visit，編譯器產生跳躍表。)
+// 4. 模組 (mod) 在執行時才載入新技能、新職業，編譯期根本不知道 —— 所以保留一條「執行時註冊」的路：
+//    執行時技能表一開始複製 constexpr 表，mod 再往後面加。
+// virtual 並沒有錯：型別真的要到執行時才知道 (例如外掛、mod)，它就是最簡單的答案。
+
+// 程式碼範例：
+#include <iostream>
+#include <string>
+#include <vector>
+#include <array>
+#include <tuple>
+#include <variant>
+#include <memory>
+#include <unordered_map>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <stdexcept>
+using namespace std;
+
+// 1. 編譯期技能表
+struct skill {
+    const char *name;
+    int damage;
+    int cost;       // 耗魔
+    int cooldown;   // 放完之後要等幾回合
+};
+enum skill_id : uint16_t { punch, whirlwind, fireball, heal, builtin_skill_count };
+
+constexpr array<skill, builtin_skill_count> skill_table = {{
+    {"揮拳",   3,  0, 0},
+    {"旋風斬", 25, 10, 2},
+    {"大火球", 60, 30, 4},
+    {"治療",   0,  20, 3},
+}};
+// 表格寫錯，編譯就不會過
+constexpr bool table_ok() {
+    for (const skill &s : skill_table)
+        if (s.damage < 0 || s.cost < 0 || s.cooldown < 0) return false;
+    return skill_table[punch].cost == 0;  // 揮拳不能耗魔，不然沒魔的時候就沒招了
+}
+static_assert(table_ok(), "技能表有錯");
+
+// 每回合的規則 (virtual / CRTP / mod 三種版本都用同一套，才比得公平)：
+// 主技能冷卻好了、魔力也夠 -> 放主技能；否則揮拳並回 5 點魔
+struct combat_state {
+    int mana = 50;
+    int cd = 0;
+    int rage = 0;
+    long dealt = 0;
+    void use(const skill &main) {
+        if (cd == 0 && mana >= main.cost) {
+            mana -= main.cost;
+            dealt += main.damage;
+            cd = main.cooldown;
+        }
+        else {
+            mana += 5;
+            dealt += skill_table[punch].damage;
+            if (cd > 0) cd--;
+        }
+    }
+};
+// 職業的被動能力，每次攻擊完觸發 (一樣三種版本共用)
+void warrior_rage(combat_state &st) {   // 戰士：每攻擊 10 次爆發一次，多 20 點傷害
+    if (++st.rage == 10) {
+        st.dealt += 20;
+        st.rage = 0;
+    }
+}
+void wizard_focus(combat_state &st) { st.mana += 2; }   // 法師：每次攻擊回 2 點魔
+void no_passive(combat_state &) {}
+
+// 2. CRTP：父類別知道兒子是誰
+template <typename Derived>
+class character_base {
+public:
+    string name;
+    combat_state st;
+    character_base(string n) : name(move(n)) {}
+    void attack() {
+        // 兒子的主技能是編譯期常數，skill_table[...] 也是編譯期常數，整段會被內嵌成幾行算術
+        constexpr skill s = skill_table[Derived::main_skill];
+        st.use(s);
+        // 呼叫兒子的 on_attack：編譯期就知道是哪一個，不用查虛擬函式表，可以內嵌
+        static_cast<Derived *>(this)->on_attack();
+    }
+    void on_attack() {}   // 預設沒有被動能力，兒子可以「遮住」這個函式 (不是 override)
+};
+class Warrior : public character_base<Warrior> {
+public:
+    static constexpr skill_id main_skill = whirlwind;
+    using character_base::character_base;
+    void on_attack() { warrior_rage(st); }
+};
+class Wizard : public character_base<Wizard> {
+public:
+    static constexpr skill_id main_skill = fireball;
+    using character_base::character_base;
+    void on_attack() { wizard_focus(st); }
+};
+class Commoner : public character_base<Commoner> {
+public:
+    static constexpr skill_id main_skill = punch;
+    using character_base::character_base;
+};
+
+// 3. 產生的分派：每個職業一個 vector，fold expression 展開成「每個職業一段迴圈」
+template <typename... Classes>
+class party {
+private:
+    tuple<vector<Classes>...> members;
+public:
+    template <typename C>
+    void add(C c) { get<vector<C>>(members).push_back(move(c)); }
+    void attack_all() {
+        (for_each(get<vector<Classes>>(members).begin(), get<vector<Classes>>(members).end(),
+                  [](Classes &c) { c.attack(); }), ...);
+    }
+    long total_damage() const {
+        long sum = 0;
+        ((sum += [](const vector<Classes> &v) {
+            long s = 0;
+            for (const Classes &c : v) s += c.st.dealt;
+            return s;
+        }(get<vector<Classes>>(members))), ...);
+        return sum;
+    }
+};
+
+// 4. 執行時註冊的路 (給 mod 用)：技能表與職業都可以在執行時增加
+// skill::name 只是 const char*，mod 傳進來的字串可能是暫時的 (讀檔讀到的 string)，
+// 所以名字一定要複製一份由 registry 自己保管。用 deque：往後加元素時，舊字串的位址不會變。
+class skill_registry {
+private:
+    vector<skill> skills{skill_table.begin(), skill_table.end()};   // 內建的技能先放進來
+    deque<string> names;
+    unordered_map<string, uint16_t> by_name;
+public:
+    skill_registry() {
+        for (uint16_t i = 0; i < skills.size(); i++) by_name[skills[i].name] = i;
+    }
+    uint16_t add(const string &name, int damage, int cost, int cooldown) {
+        if (skills.size() > UINT16_MAX) throw length_error("技能編號用完了 (最多 65536 個)");
+        if (by_name.count(name)) throw invalid_argument("技能名稱重複: " + name);
+        // 三份資料要一起成功：會配置記憶體 (可能 throw) 的先做，失敗就把前面加的收回來
+        skills.reserve(skills.size() + 1);   // 先保留位置，後面的 push_back 就不會 throw
+        names.push_back(name);
+        skills.push_back({names.back().c_str(), damage, cost, cooldown});
+        uint16_t id = skills.size() - 1;
+        try {
+            by_name.emplace(names.back(), id);
+        }
+        catch (...) {
+            skills.pop_back();
+            names.pop_back();
+            throw;
+        }
+        return id;
+    }
+    uint16_t find(const string &name) const { return by_name.at(name); }
+    const skill &operator[](uint16_t id) const { return skills[id]; }
+};
+class mod_character {
+public:
+    string name;
+    combat_state st;
+    uint16_t main_skill;     // 執行時才知道，所以每次都要查表
+    const skill_registry *reg;
+    void (*passive)(combat_state &);   // 被動能力也是執行時才決定，只能用函式指標
+    mod_character(string n, uint16_t s, const skill_registry &r, void (*p)(combat_state &) = no_passive)
+        : name(move(n)), main_skill(s), reg(&r), passive(p) {}
+    void attack() {
+        st.use((*reg)[main_skill]);
+        passive(st);
+    }
+};
+
+// 對照組：傳統的 virtual 版本
+class VCharacter {
+public:
+    string name;
+    combat_state st;
+    VCharacter(string n) : name(move(n)) {}
+    virtual ~VCharacter() {}
+    virtual void attack() { st.use(skill_table[punch]); }
+};
+class VWarrior : public VCharacter {
+public:
+    using VCharacter::VCharacter;
+    void attack() override {
+        st.use(skill_table[whirlwind]);
+        warrior_rage(st);
+    }
+};
+class VWizard : public VCharacter {
+public:
+    using VCharacter::VCharacter;
+    void attack() override {
+        st.use(skill_table[fireball]);
+        wizard_focus(st);
+    }
+};
+
+template <typename F>
+double timed(F f) {
+    auto t0 = chrono::steady_clock::now();
+    f();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char **argv) {
+    // 用法: ./a.out [角色數量] [回合數]
+    int n = argc > 1 ? stoi(argv[1]) : 300000;
+    int rounds = argc > 2 ? stoi(argv[2]) : 200;
+
+    // 同一批角色 (0 = 戰士, 1 = 法師, 2 = 路人)，打亂順序，讓 virtual 版本的分支預測不能偷懶
+    vector<int> kinds(n);
+    for (int i = 0; i < n; i++) kinds[i] = i % 3;
+    shuffle(kinds.begin(), kinds.end(), mt19937(1));
+
+    vector<unique_ptr<VCharacter>> vparty;
+    party<Warrior, Wizard, Commoner> cparty;
+    vector<variant<Warrior, Wizard, Commoner>> varparty;
+    for (int k : kinds) {
+        if (k == 0) {
+            vparty.push_back(make_unique<VWarrior>("亞瑟"));
+            cparty.add(Warrior("亞瑟"));
+            varparty.emplace_back(Warrior("亞瑟"));
+        }
+        else if (k == 1) {
+            vparty.push_back(make_unique<VWizard>("梅林"));
+            cparty.add(Wizard("梅林"));
+            varparty.emplace_back(Wizard("梅林"));
+        }
+        else {
+            vparty.push_back(make_unique<VCharacter>("路人"));
+            cparty.add(Commoner("路人"));
+            varparty.emplace_back(Commoner("路人"));
+        }
+    }
+    // mod：執行時註冊一招「冰錐」和一個新職業「冰法師」，其他角色沿用內建技能
+    skill_registry reg;
+    uint16_t ice;
+    {
+        string from_file = "冰錐";   // 假裝是從 mod 檔讀進來的，離開這個區塊就不見了
+        ice = reg.add(from_file, 40, 15, 1);
+    }
+    try {
+        reg.add("旋風斬", 999, 0, 0);
+    }
+    catch (const invalid_argument &e) {
+        cout << "擋下重複註冊: " << e.what() << endl;
+    }
+    vector<mod_character> mparty;
+    for (int k : kinds) {
+        if (k == 0) mparty.emplace_back("亞瑟", reg.find("旋風斬"), reg, warrior_rage);
+        else if (k == 1) mparty.emplace_back("梅林", reg.find("大火球"), reg, wizard_focus);
+        else mparty.emplace_back("路人", reg.find("揮拳"), reg);
+    }
+    mod_character frost("冰法師", ice, reg, wizard_focus);
+    for (int r = 0; r < 3; r++) frost.attack();
+    cout << frost.name << " 用 " << reg[ice].name << " 打了 3 回合，總傷害 " << frost.st.dealt << endl;
+
+    double t_virtual = timed([&] {
+        for (int r = 0; r < rounds; r++)
+            for (auto &p : vparty) p->attack();
+    });
+    double t_crtp = timed([&] {
+        for (int r = 0; r < rounds; r++) cparty.attack_all();
+    });
+    double t_variant = timed([&] {
+        for (int r = 0; r < rounds; r++)
+            for (auto &c : varparty) visit([](auto &x) { x.attack(); }, c);
+    });
+    double t_mod = timed([&] {
+        for (int r = 0; r < rounds; r++)
+            for (auto &c : mparty) c.attack();
+    });
+
+    long d_virtual = 0, d_variant = 0, d_mod = 0;
+    for (auto &p : vparty) d_virtual += p->st.dealt;
+    for (auto &c : varparty) d_variant += visit([](auto &x) { return x.st.dealt; }, c);
+    for (auto &c : mparty) d_mod += c.st.dealt;
+    long d_crtp = cparty.total_damage();
+
+    cout << n << " 個角色 x " << rounds << " 回合 (毫秒):" << endl;
+    cout << "  virtual attack():        " << t_virtual << endl;
+    cout << "  CRTP + 每職業一個 vector: " << t_crtp << endl;
+    cout << "  variant + visit:         " << t_variant << endl;
+    cout << "  執行時技能表 (mod):       " << t_mod << endl;
+    bool same = d_virtual == d_crtp && d_crtp == d_variant && d_variant == d_mod;
+    cout << "總傷害 " << d_crtp << (same ? " (四種做法一致)" : " (不一致!)") << endl;
+    return same ? 0 : 1;
+}
+// 重點筆記：
+// 1. constexpr 技能表：數值在編譯期就確定，還可以用 static_assert 擋掉寫錯的表。
+// 2. CRTP：父類別樣板用 static_cast<Derived*>(this)->on_attack() 呼叫兒子，編譯期就決定好，可以內嵌，沒有 vptr。
+//    兒子沒寫的函式會落回父類別的預設版本，效果像 virtual 的預設實作。
+// 3. 不同職業混在一起時，「每個職業一個 vector」最快 (同一段迴圈只處理一種型別)；
+//    要保留原本的順序就用 variant + visit。
+// 4. 執行時才知道的東西 (mod) 還是要查表或用 virtual；編譯期多型和執行時多型可以並存。
+// 5. registry 要自己保管技能名稱 (const char* 指向別人的字串會懸空)，並擋掉重複名稱與用完的 uint16_t 編號。
@@ -104,3 +104,638 @@ int main() {
 // A. Vector: 用來取代 malloc 出來的動態陣列。用 push_back 加資料，用 size() 看大小。
 // B. String: 用來取代 char*。用 + 接字串，用 == 比對。
 // C. Auto: 讓編譯器自己猜型別，寫迴圈超方便。
+
+
+// 補充 : 字串駐留 (String Interning) —— 幾百萬個角色，名字卻只有幾千種
+// CH4 的 player、CH5 的 character、CH6 的 Character、CH9 的 Pet 都用 string name，
+// 而且建構子是傳值 (string n)，每建一個角色就複製一次字串。
+// 遊戲裡有幾百萬隻怪物，但名字 ("史萊姆"、"哥布林弓箭手") 其實只有幾千種，同一個字串被存了幾十萬遍。
+// 解法：全域一張「字串登記表」，每種字串只存一份，物件裡只放一個 32-bit 的號碼 (symbol)。
+// 好處：
+// a. 每個物件的名字從 32 bytes (+ 可能的 Heap 空間) 變成 4 bytes。
+// b. 比較名字 == 變成比較兩個整數，不用一個字一個字比。
+// c. 建立物件不用再配置字串記憶體。
+// 代價：登記表裡的字串永遠不刪 (適合名字、標籤這種「種類有限」的字串，不適合聊天內容)。
+
+// 設計筆記 (thread-safe)：
+// 分片 (sharding)：用雜湊值把字串分到 16 個分片，每個分片各有一把鎖，新增時大家不會搶同一把。
+// 查詢不上鎖 (lock-free lookup)：雜湊表的每一格是 atomic，讀的人直接看；只有「新增」才上鎖。
+// 表格滿了就換一張兩倍大的新表，舊表不刪 (還有讀者可能正在看)，等登記表整個死掉才一起收。
+
+// 程式碼範例 :
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>  // max
+#include <stdexcept>  // length_error
+using namespace std;
+
+// 名字的號碼牌：只有 4 bytes，比較就是比整數
+// 號碼 = (分片內編號 + 1) << 4 | 分片編號，所以 0 永遠不會被發出去，拿來當「還沒取名字」
+class symbol {
+private:
+    uint32_t id;
+public:
+    explicit symbol(uint32_t i = 0) : id(i) {}
+    uint32_t raw() const { return id; }
+    bool operator==(symbol o) const { return id == o.id; }
+    bool operator!=(symbol o) const { return id != o.id; }
+};
+
+class interner {
+private:
+    static const int shardbits = 4;                 // 16 個分片，號碼的低 4 bits 就是分片編號
+    static const int nshards = 1 << shardbits;
+    static const uint32_t pagesize = 1 << 16;       // 每頁 65536 個字串
+    static const uint32_t maxpages = (1u << (32 - shardbits)) / pagesize;
+
+    struct entry {
+        const char *p;
+        uint32_t len;
+    };
+    // 雜湊表：每格存 (雜湊值高 32 bits << 32) | (分片內編號 + 1)，0 代表空格
+    struct table {
+        size_t mask;
+        unique_ptr<atomic<uint64_t>[]> slots;
+        explicit table(size_t cap) : mask(cap - 1), slots(new atomic<uint64_t>[cap]) {
+            for (size_t i = 0; i < cap; i++) slots[i].store(0, memory_order_relaxed);
+        }
+    };
+    struct alignas(64) shard {                      // 對齊快取線，分片之間不互相干擾
+        mutex mu;                                   // 只有新增時才用
+        atomic<table*> current{nullptr};
+        vector<unique_ptr<table>> tables;           // 包含舊表，讀者可能還在看，所以先不刪
+        atomic<entry*> pages[maxpages] = {};
+        vector<unique_ptr<entry[]>> page_owner;
+        vector<unique_ptr<char[]>> arena;           // 字串內容放在大塊記憶體裡，一塊 64KB
+        size_t arena_used = 0, arena_cap = 0;
+        uint32_t count = 0;
+        size_t bytes = 0;                           // 這個分片總共用了多少記憶體
+    };
+    shard shards[nshards];
+
+    static uint64_t hash(string_view s) {           // FNV-1a
+        uint64_t h = 1469598103934665603ULL;
+        for (unsigned char c : s) h = (h ^ c) * 1099511628211ULL;
+        return h ^ (h >> 29);
+    }
+    static string_view text(const shard &sh, uint32_t local) {
+        const entry &e = sh.pages[local / pagesize].load(memory_order_acquire)[local % pagesize];
+        return string_view(e.p, e.len);
+    }
+    // 不上鎖的查詢：找到就回傳號碼，找不到回傳 0
+    static uint32_t find(const shard &sh, const table *t, uint64_t h, string_view s, int idx) {
+        if (t == nullptr) return 0;
+        uint64_t tag = h & 0xFFFFFFFF00000000ULL;
+        for (size_t i = (h >> shardbits) & t->mask; ; i = (i + 1) & t->mask) {
+            uint64_t v = t->slots[i].load(memory_order_acquire);
+            if (v == 0) return 0;
+            if ((v & 0xFFFFFFFF00000000ULL) == tag) {
+                uint32_t local = (uint32_t)v - 1;
+                if (text(sh, local) == s) return ((local + 1) << shardbits) | idx;
+            }
+        }
+    }
+    static void place(table *t, uint64_t h, uint64_t v) {
+        size_t i = (h >> shardbits) & t->mask;
+        while (t->slots[i].load(memory_order_relaxed) != 0) i = (i + 1) & t->mask;
+        t->slots[i].store(v, memory_order_release);
+    }
+    uint32_t insert(shard &sh, uint64_t h, string_view s, int idx) {
+        lock_guard<mutex> lk(sh.mu);
+        table *t = sh.current.load(memory_order_relaxed);
+        if (uint32_t id = find(sh, t, h, s, idx)) return id;  // 等鎖的時候別人已經加好了
+        // 先檢查再動手：throw 的時候 count 和表格都還是原來的樣子
+        uint32_t local = sh.count;
+        if (local + 1 >= (uint32_t)maxpages * pagesize) throw length_error("interner: 分片滿了");
+
+        // 1. 字串內容複製到 arena
+        if (sh.arena.empty() || sh.arena_used + s.size() > sh.arena_cap) {
+            sh.arena_cap = max<size_t>(65536, s.size());
+            sh.arena.push_back(make_unique<char[]>(sh.arena_cap));
+            sh.arena_used = 0;
+            sh.bytes += sh.arena_cap;
+        }
+        char *p = sh.arena.back().get() + sh.arena_used;
+        memcpy(p, s.data(), s.size());
+        sh.arena_used += s.size();
+
+        // 2. 登記到「號碼 -> 字串」的頁表
+        if (sh.pages[local / pagesize].load(memory_order_relaxed) == nullptr) {   // 上一次在這之後失敗的話，這頁已經有了
+            sh.page_owner.push_back(make_unique<entry[]>(pagesize));
+            sh.pages[local / pagesize].store(sh.page_owner.back().get(), memory_order_release);
+            sh.bytes += pagesize * sizeof(entry);
+        }
+        sh.page_owner.back()[local % pagesize] = {p, (uint32_t)s.size()};
+
+        // 3. 表格超過一半滿就換兩倍大的新表 (舊表留著給還在讀的人)
+        if (t == nullptr || (size_t)(local + 1) * 2 > t->mask + 1) {
+            size_t cap = t == nullptr ? 1024 : (t->mask + 1) * 2;
+            sh.tables.push_back(make_unique<table>(cap));
+            table *bigger = sh.tables.back().get();
+            for (uint32_t k = 0; k < local; k++) {
+                place(bigger, hash(text(sh, k)), (hash(text(sh, k)) & 0xFFFFFFFF00000000ULL) | (k + 1));
+            }
+            sh.current.store(bigger, memory_order_release);
+            sh.bytes += cap * sizeof(atomic<uint64_t>);
+            t = bigger;
+        }
+        // 4. 最後才把號碼放進雜湊表 (release)：讀者看到號碼時，字串內容一定已經寫好了
+        //    count 也到這裡才加：前面任何一步 throw (配置失敗)，這個號碼就當作沒發過
+        sh.count = local + 1;
+        place(t, h, (h & 0xFFFFFFFF00000000ULL) | (local + 1));
+        return ((local + 1) << shardbits) | idx;
+    }
+
+public:
+    // 全域唯一的登記表 (static 區域變數：第一次用到才建立，而且 thread-safe)
+    static interner& global() {
+        static interner g;
+        return g;
+    }
+    symbol intern(string_view s) {
+        uint64_t h = hash(s);
+        int idx = h & (nshards - 1);
+        shard &sh = shards[idx];
+        uint32_t id = find(sh, sh.current.load(memory_order_acquire), h, s, idx);
+        if (id == 0) id = insert(sh, h, s, idx);
+        return symbol(id);
+    }
+    string_view str(symbol sym) const {
+        if (sym.raw() == 0) return string_view();
+        return text(shards[sym.raw() & (nshards - 1)], (sym.raw() >> shardbits) - 1);
+    }
+    size_t size() {
+        size_t n = 0;
+        for (shard &sh : shards) {
+            lock_guard<mutex> lk(sh.mu);
+            n += sh.count;
+        }
+        return n;
+    }
+    size_t memory_bytes() {
+        size_t n = sizeof(*this);
+        for (shard &sh : shards) {
+            lock_guard<mutex> lk(sh.mu);
+            n += sh.bytes;
+        }
+        return n;
+    }
+};
+symbol intern(string_view s) { return interner::global().intern(s); }
+string_view str(symbol s) { return interner::global().str(s); }
+
+// 各章的角色改成存 symbol
+class player {      // CH4
+public:
+    symbol name;
+    player(string_view n) : name(intern(n)) {}
+    void attack() { cout << str(name) << " 揮了一劍！" << endl; }
+};
+class character {   // CH5
+public:
+    symbol name;
+    int hp = 100;
+    character(string_view n) : name(intern(n)) {}
+    void eat() {
+        hp += 10;
+        cout << str(name) << " 吃了一塊肉, HP 恢復到 " << hp << endl;
+    }
+};
+class Character {   // CH6
+public:
+    symbol name;
+    Character(string_view n) : name(intern(n)) {}
+    virtual ~Character() {}
+    virtual void attack() { cout << str(name) << " 揮了一拳 (普通攻擊)" << endl; }
+};
+class Pet {         // CH9
+public:
+    symbol name;
+    Pet(string_view n) : name(intern(n)) {}
+    void bark() { cout << str(name) << ": 汪！" << endl; }
+};
+
+// 一個 string 實際吃掉的記憶體：物件本身 + 超過 SSO (短字串最佳化) 才有的 Heap 空間
+size_t string_bytes(const string &s) {
+    return sizeof(string) + (s.capacity() > 15 ? s.capacity() + 1 : 0);
+}
+
+int main() {
+    // 1. 用起來跟原本一樣
+    player p("亞瑟");
+    Pet dog("小黑");
+    p.attack();
+    dog.bark();
+    cout << "同名比較 (只比整數): " << (character("亞瑟").name == p.name ? "同一個名字" : "不同名字") << endl;
+
+    // 2. 多執行緒一起登記同一批名字，大家拿到的號碼必須一樣
+    const int kinds = 5000;
+    vector<vector<symbol>> got(4, vector<symbol>(kinds));
+    vector<thread> workers;
+    for (int t = 0; t < 4; t++) {
+        workers.emplace_back([&got, t] {
+            for (int i = 0; i < kinds; i++) got[t][i] = intern("哥布林弓箭手 Lv." + to_string(i));
+        });
+    }
+    for (auto &w : workers) w.join();
+    bool same = true;
+    for (int t = 1; t < 4; t++) same = same && got[t] == got[0];
+    cout << "4 個執行緒同時登記: " << (same ? "號碼一致" : "號碼不一致!") << endl;
+
+    // 3. 記憶體報告：三百萬隻怪物，名字只有 5000 種
+    const size_t monsters = 3000000;
+    vector<string> by_string;
+    vector<symbol> by_symbol;
+    by_string.reserve(monsters);
+    by_symbol.reserve(monsters);
+    size_t string_total = 0;
+    for (size_t i = 0; i < monsters; i++) {
+        string n = "哥布林弓箭手 Lv." + to_string(i % kinds);
+        by_symbol.push_back(intern(n));
+        by_string.push_back(n);
+        string_total += string_bytes(by_string.back());
+    }
+    size_t symbol_total = monsters * sizeof(symbol) + interner::global().memory_bytes();
+    cout << "名字用 string 存: " << string_total / (1024 * 1024) << " MB" << endl;
+    cout << "名字用 symbol 存: " << symbol_total / (1024 * 1024) << " MB (含登記表本身, "
+         << interner::global().size() << " 種名字)" << endl;
+    cout << "省下: " << (string_total - symbol_total) / (1024 * 1024) << " MB" << endl;
+    return 0;
+}
+// 重點筆記：
+// 1. 種類少、數量多的字串 (名字、標籤、技能名稱) 適合駐留；內容一直變的字串不適合。
+// 2. symbol 只是一個整數：複製、比較、當 map 的 key 都是 O(1)，要印出來時再用 str() 查回文字。
+// 3. 查詢完全不上鎖，只有第一次登記新字串時才鎖住「一個分片」。
+
+
+// 補充 : 一個回合用一塊記憶體 (pmr 自訂記憶體資源)
+// vector、string、unordered_map 需要記憶體時，預設都去找全域的 new / delete (malloc)。
+// 遊戲每一個回合 (tick) 都會建一堆暫時的容器：這回合的隊伍、傷害清單、統計表...
+// 回合結束全部丟掉，下一回合再重新要 —— 每一次 push_back 長大、每一個 map 節點都是一次 malloc / free。
+// C++17 的 std::pmr (polymorphic memory resource) 讓容器可以換「記憶體從哪裡來」，容器的用法完全不變：
+//     pmr::vector<int> v(&arena);   // 跟 vector<int> 一模一樣，只是記憶體跟 arena 要
+// 這裡自己做三種記憶體資源 (都繼承 pmr::memory_resource，只要實作 do_allocate / do_deallocate)：
+// 1. arena (monotonic)：一大塊記憶體，要多少就往後切多少 (bump pointer)，個別的 free 什麼都不做；
+//    回合結束呼叫 release() 一次全部作廢，下一回合從頭再切。
+// 2. pool (大小級距)：16、32、64...2048 bytes 各一條 free list，釋放的區塊放回去給下一次用。
+// 3. thread cache：很多執行緒共用一個上鎖的 pool 時，每條執行緒先在自己的小快取裡拿 / 還，
+//    快取空了或滿了才一次跟共用 pool 搬 32 個，鎖的次數少很多。
+// 每個資源都有統計數字 (配置幾次、目前用了多少、跟上游要了幾次)，才知道換了之後到底有沒有差。
+
+// 程式碼範例：
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <memory_resource>
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <bit>
+#include <cstdio>
+#include <cstdint>
+using namespace std;
+
+struct resource_stats {
+    size_t allocs = 0;      // 配置次數
+    size_t deallocs = 0;
+    size_t in_use = 0;      // 目前用了多少 bytes
+    size_t peak = 0;
+    size_t upstream = 0;    // 跟上游 (malloc 或共用 pool) 要了幾次
+    void on_alloc(size_t n) {
+        allocs++;
+        in_use += n;
+        peak = max(peak, in_use);
+    }
+    void on_dealloc(size_t n) {
+        deallocs++;
+        in_use -= n;
+    }
+};
+
+// 0. 統計用的外殼：包住任何一個資源 (例如預設的 new / delete)，數它被叫了幾次 (單執行緒用)
+class counting_resource : public pmr::memory_resource {
+private:
+    pmr::memory_resource *up;
+public:
+    resource_stats st;
+    explicit counting_resource(pmr::memory_resource *u = pmr::new_delete_resource()) : up(u) {}
+private:
+    void *do_allocate(size_t n, size_t align) override {
+        st.on_alloc(n);
+        st.upstream++;
+        return up->allocate(n, align);
+    }
+    void do_deallocate(void *p, size_t n, size_t align) override {
+        st.on_dealloc(n);
+        up->deallocate(p, n, align);
+    }
+    bool do_is_equal(const pmr::memory_resource &o) const noexcept override { return this == &o; }
+};
+
+// 1. arena：往後切，release() 一次清空
+class arena_resource : public pmr::memory_resource {
+private:
+    pmr::memory_resource *up;
+    vector<pair<char*, size_t>> chunks;   // 跟上游要來的大塊
+    size_t next_size;
+    char *cur = nullptr;
+    char *end = nullptr;
+    void grow(size_t at_least) {
+        size_t sz = max(next_size, at_least);
+        char *p = (char*)up->allocate(sz, alignof(max_align_t));
+        st.upstream++;
+        chunks.push_back({p, sz});
+        cur = p;
+        end = p + sz;
+        next_size = sz * 2;
+    }
+public:
+    resource_stats st;
+    explicit arena_resource(size_t first_chunk = 64 * 1024, pmr::memory_resource *u = pmr::new_delete_resource())
+        : up(u), next_size(first_chunk) {}
+    ~arena_resource() {
+        for (auto [p, sz] : chunks) up->deallocate(p, sz, alignof(max_align_t));
+    }
+    // 回合結束：全部作廢。如果這回合用了好幾塊，就合併成一塊大的，下回合一塊就夠了
+    void release() {
+        if (chunks.size() > 1) {
+            size_t total = 0;
+            for (auto [p, sz] : chunks) {
+                total += sz;
+                up->deallocate(p, sz, alignof(max_align_t));
+            }
+            chunks.clear();
+            next_size = total;
+            grow(total);
+        }
+        else if (!chunks.empty()) {
+            cur = chunks[0].first;
+        }
+        st.in_use = 0;
+    }
+private:
+    void *do_allocate(size_t n, size_t align) override {
+        st.on_alloc(n);
+        uintptr_t p = ((uintptr_t)cur + align - 1) & ~(uintptr_t)(align - 1);
+        if (cur == nullptr || p + n > (uintptr_t)end) {
+            grow(n + align);
+            p = ((uintptr_t)cur + align - 1) & ~(uintptr_t)(align - 1);
+        }
+        cur = (char*)(p + n);
+        return (void*)p;
+    }
+    void do_deallocate(void *, size_t n, size_t) override { st.on_dealloc(n); }  // 什麼都不做，等 release()
+    bool do_is_equal(const pmr::memory_resource &o) const noexcept override { return this == &o; }
+};
+
+// 2. pool：依照大小分級距，每一級一條 free list
+const size_t pool_classes = 8;                        // 16, 32, 64, ..., 2048 bytes
+size_t class_of(size_t n) { return bit_width((max<size_t>(n, 16) - 1) >> 4); }
+size_t class_size(size_t c) { return size_t(16) << c; }
+
+class pool_resource : public pmr::memory_resource {
+private:
+    struct block { block *next; };
+    static const size_t page_size = 64 * 1024;
+    pmr::memory_resource *up;
+    block *lists[pool_classes] = {};
+    vector<void*> pages;
+    void refill(size_t c) {
+        char *p = (char*)up->allocate(page_size, 16);
+        st.upstream++;
+        pages.push_back(p);
+        size_t sz = class_size(c);
+        for (size_t off = 0; off + sz <= page_size; off += sz) put(c, p + off);
+    }
+public:
+    resource_stats st;
+    explicit pool_resource(pmr::memory_resource *u = pmr::new_delete_resource()) : up(u) {}
+    ~pool_resource() {
+        for (void *p : pages) up->deallocate(p, page_size, 16);
+    }
+    static bool pooled(size_t n, size_t align) { return n <= class_size(pool_classes - 1) && align <= 16; }
+    // 給 thread cache 用的：直接拿 / 還一個某級距的區塊 (不算統計)
+    void *get(size_t c) {
+        if (lists[c] == nullptr) refill(c);
+        block *b = lists[c];
+        lists[c] = b->next;
+        return b;
+    }
+    void put(size_t c, void *p) {
+        block *b = (block*)p;
+        b->next = lists[c];
+        lists[c] = b;
+    }
+    pmr::memory_resource *upstream() const { return up; }
+private:
+    void *do_allocate(size_t n, size_t align) override {
+        st.on_alloc(n);
+        if (!pooled(n, align)) {
+            st.upstream++;
+            return up->allocate(n, align);    // 太大的直接跟上游要
+        }
+        return get(class_of(n));
+    }
+    void do_deallocate(void *p, size_t n, size_t align) override {
+        st.on_dealloc(n);
+        if (!pooled(n, align)) up->deallocate(p, n, align);
+        else put(class_of(n), p);
+    }
+    bool do_is_equal(const pmr::memory_resource &o) const noexcept override { return this == &o; }
+};
+
+// 很多執行緒共用的 pool：每次都上鎖 (對照組)，另外提供「一次搬很多個」給 thread cache 用
+class shared_pool : public pmr::memory_resource {
+private:
+    mutex mu;
+    pool_resource pool;
+public:
+    size_t lock_count = 0;
+    void take(size_t c, void **out, int count) {
+        lock_guard<mutex> lk(mu);
+        lock_count++;
+        for (int i = 0; i < count; i++) out[i] = pool.get(c);
+    }
+    void give(size_t c, void *const *blocks, int count) {
+        lock_guard<mutex> lk(mu);
+        lock_count++;
+        for (int i = 0; i < count; i++) pool.put(c, blocks[i]);
+    }
+private:
+    void *do_allocate(size_t n, size_t align) override {
+        lock_guard<mutex> lk(mu);
+        lock_count++;
+        return pool.allocate(n, align);
+    }
+    void do_deallocate(void *p, size_t n, size_t align) override {
+        lock_guard<mutex> lk(mu);
+        lock_count++;
+        pool.deallocate(p, n, align);
+    }
+    bool do_is_equal(const pmr::memory_resource &o) const noexcept override { return this == &o; }
+};
+
+// 3. thread cache：每條執行緒一個，放在共用 pool 前面
+class thread_cache_resource : public pmr::memory_resource {
+private:
+    static const int batch = 32;
+    static const int limit = 2 * batch;
+    shared_pool *shared;
+    void *cache[pool_classes][limit];
+    int count[pool_classes] = {};
+public:
+    resource_stats st;
+    explicit thread_cache_resource(shared_pool &s) : shared(&s) {}
+    ~thread_cache_resource() {
+        for (size_t c = 0; c < pool_classes; c++)
+            if (count[c]) shared->give(c, cache[c], count[c]);   // 執行緒結束時全部還回去
+    }
+private:
+    void *do_allocate(size_t n, size_t align) override {
+        st.on_alloc(n);
+        if (!pool_resource::pooled(n, align)) {
+            st.upstream++;
+            return shared->allocate(n, align);
+        }
+        size_t c = class_of(n);
+        if (count[c] == 0) {                   // 快取空了：一次搬 32 個過來
+            st.upstream++;
+            shared->take(c, cache[c], batch);
+            count[c] = batch;
+        }
+        return cache[c][--count[c]];
+    }
+    void do_deallocate(void *p, size_t n, size_t align) override {
+        st.on_dealloc(n);
+        if (!pool_resource::pooled(n, align)) {
+            shared->deallocate(p, n, align);
+            return;
+        }
+        size_t c = class_of(n);
+        if (count[c] == limit) {               // 快取滿了：還一半回去
+            st.upstream++;
+            shared->give(c, cache[c] + batch, batch);
+            count[c] = batch;
+        }
+        cache[c][count[c]++] = p;
+    }
+    bool do_is_equal(const pmr::memory_resource &o) const noexcept override { return this == &o; }
+};
+
+// ---- pmr 版本的章節類別 ----
+// CH5 的 character：名字改用 pmr::string，並且「認得」allocator，
+// 放進 pmr::vector 時，vector 會自動把自己的記憶體資源傳給每一個 character 的名字
+class character {
+public:
+    using allocator_type = pmr::polymorphic_allocator<>;
+    pmr::string name;
+    int hp = 100;
+    character(string_view n, allocator_type a = {}) : name(n, a) {}
+    character(const character &o, allocator_type a = {}) : name(o.name, a), hp(o.hp) {}
+    character(character &&o) = default;
+    character(character &&o, allocator_type a) : name(move(o.name), a), hp(o.hp) {}
+    character &operator=(const character&) = default;
+    character &operator=(character&&) = default;
+};
+
+// 一個回合：建隊伍、算傷害 (CH10 的 count_if)、做統計表、寫戰鬥紀錄，回合結束全部丟掉
+long game_tick(pmr::memory_resource *mr, int round) {
+    pmr::vector<character> party(mr);
+    char buf[64];
+    for (int i = 0; i < 300; i++) {
+        int len = snprintf(buf, sizeof(buf), "Knight of the Round Table #%d", (i * 7 + round) % 1000);
+        party.emplace_back(string_view(buf, len));  // 名字超過 15 字元：一定要配置記憶體
+        party.back().hp = (i * 37 + round) % 100;
+    }
+    pmr::vector<int> dmg(mr);
+    for (auto &c : party) dmg.push_back(c.hp * 3 % 101);
+    long hits = count_if(dmg.begin(), dmg.end(), [](int d) { return d > 50; });
+    pmr::unordered_map<int, int> by_hp(mr);
+    for (auto &c : party) by_hp[c.hp / 10]++;
+    pmr::string log(mr);
+    for (int i = 0; i < 50; i++) log += party[i].name;
+    return hits + (long)by_hp.size() + (long)log.size();
+}
+
+template <typename F>
+double ns_per(int times, F f) {
+    auto t0 = chrono::steady_clock::now();
+    for (int i = 0; i < times; i++) f(i);
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count() / times;
+}
+
+int main(int argc, char **argv) {
+    // 用法: ./a.out [回合數] [執行緒數]
+    int ticks = argc > 1 ? stoi(argv[1]) : 5000;
+    int threads = argc > 2 ? stoi(argv[2]) : 4;
+    long check = 0;
+
+    // 單執行緒：同一個回合，換三種記憶體來源
+    counting_resource heap;                           // 之前：每次都找 new / delete
+    double t_heap = ns_per(ticks, [&](int r) { check += game_tick(&heap, r); });
+
+    pool_resource pool;                               // 之後 (1)：大小級距的 pool
+    double t_pool = ns_per(ticks, [&](int r) { check -= game_tick(&pool, r); });
+
+    arena_resource arena;                             // 之後 (2)：一回合一塊 arena
+    double t_arena = ns_per(ticks, [&](int r) {
+        check += game_tick(&arena, r);
+        arena.release();                              // 回合結束，一次全部作廢
+    });
+    check -= [&] {                                    // 再跑一次預設配置器，讓 check 正負抵銷
+        long s = 0;
+        for (int r = 0; r < ticks; r++) s += game_tick(pmr::new_delete_resource(), r);
+        return s;
+    }();
+
+    auto per = [&](size_t x) { return (double)x / ticks; };
+    cout << "每回合                  時間(ns)    配置次數    跟上游要了幾次" << endl;
+    cout << "  new/delete (之前)     " << t_heap << "\t" << per(heap.st.allocs) << "\t\t" << per(heap.st.upstream) << endl;
+    cout << "  pool                  " << t_pool << "\t" << per(pool.st.allocs) << "\t\t" << per(pool.st.upstream) << endl;
+    cout << "  arena + release()     " << t_arena << "\t" << per(arena.st.allocs) << "\t\t" << per(arena.st.upstream) << endl;
+    cout << "  arena 一回合最多用了 " << arena.st.peak / 1024 << " KB" << endl;
+
+    // 多執行緒：共用一個上鎖的 pool vs 每條執行緒前面加一層快取
+    auto run_threads = [&](auto make_resource_and_run) {
+        vector<thread> ts;
+        auto t0 = chrono::steady_clock::now();
+        for (int t = 0; t < threads; t++) ts.emplace_back(make_resource_and_run);
+        for (auto &t : ts) t.join();
+        return chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count() / ((double)ticks * threads);
+    };
+    shared_pool shared_locked, shared_cached;
+    double t_locked = run_threads([&] {
+        for (int r = 0; r < ticks; r++) game_tick(&shared_locked, r);
+    });
+    double t_cached = run_threads([&] {
+        thread_cache_resource cache(shared_cached);   // 每條執行緒自己的快取
+        for (int r = 0; r < ticks; r++) game_tick(&cache, r);
+    });
+    double t_malloc = run_threads([&] {
+        for (int r = 0; r < ticks; r++) game_tick(pmr::new_delete_resource(), r);
+    });
+    cout << threads << " 條執行緒，每回合平均:" << endl;
+    cout << "  共用 pool 每次上鎖:   " << t_locked << " ns，上鎖 " << shared_locked.lock_count / ((double)ticks * threads) << " 次" << endl;
+    cout << "  thread cache + pool:  " << t_cached << " ns，上鎖 " << shared_cached.lock_count / ((double)ticks * threads) << " 次" << endl;
+    cout << "  new/delete (malloc):  " << t_malloc << " ns" << endl;
+    cout << (check == 0 ? "四種記憶體來源算出來的結果一致" : "結果不一致!") << endl;
+    return check == 0 ? 0 : 1;
+}
+// 重點筆記：
+// 1. pmr 容器的用法跟一般容器一模一樣，只是建構時多傳一個 memory_resource*。
+// 2. 類別要「認得 allocator」(allocator_type + 多一個 allocator 參數的建構子)，
+//    放進 pmr::vector 時名字才會跟著用同一個資源。
+// 3. arena 最適合「一起生、一起死」的暫時資料：個別 free 是零成本，回合結束一次清光。
+// 4. 多執行緒共用 pool 會卡在鎖上；每條執行緒一層快取、一次搬一批，鎖的次數就少很多。
+// 5. 先量再換：統計數字 (配置次數、跟上游要了幾次) 會告訴你換了之後省下什麼。
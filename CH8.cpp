@@ -43,6 +43,7 @@ int main() {
 // 假設我們想做一個簡單的 Box (盒子)，裡面可以裝任何東西。
 // 程式碼範例：萬能盒子
 #include <iostream>
+#include <utility>  // move
 using namespace std;
 // 定義一個樣板類別
 template <typename T>
@@ -51,7 +52,8 @@ private:
     T item;  // 盒子裡裝的東西，型別是 T (未知)
 public:
     // 建構子：把東西裝進去
-    Box(T i) : item(i) {}
+    // 用 move 把參數「搬」進 item，T 是 string、vector 這種大東西時才不會複製兩次
+    Box(T i) : item(move(i)) {}
 
     // 把東西印出來
     void show() {
@@ -107,3 +109,810 @@ int main() {
 
 // 現在知道為什麼 vector 後面要加 <int> 了吧？
 // 因為 vector 本身就是一個寫好的 Class Template
+
+
+// 補充 : 建構子到底配置了幾次記憶體？ (move 與完美轉發)
+// 前面幾章的建構子都長這樣：player(string n) { name = n; }
+// 看起來很無害，但如果名字比較長 (超過 15 個字元，放不進 string 內建的小緩衝區 SSO)：
+// 第 1 次配置：呼叫端把字串「複製」進參數 n。
+// 第 2 次配置：name = n 又把 n「複製」進 name，然後 n 在函式結束時被丟掉。
+// 明明 n 馬上就要死了，為什麼不直接把它的內容「搬」過去？這就是 move：
+// player(string n) : name(move(n)) {}
+// 呼叫端給左值 (有名字的變數) -> 複製 1 次；呼叫端給右值 (暫時物件、move(x)) -> 0 次。
+// 所以各章的 player / character / Character / Pet / Box 建構子都已經改成 move 的版本了。
+
+// 完美轉發 (Perfect Forwarding)
+// 如果要寫一個「幫你建立物件」的樣板工廠函式，參數要怎麼傳才不會多複製？
+// template <typename T, typename... Args>
+// T make(Args&&... args) { return T(forward<Args>(args)...); }
+// Args&& 在樣板裡叫做「轉發參考 (forwarding reference)」：
+// 傳左值進來就是左值參考，傳右值進來就是右值參考，forward 會把它「原汁原味」地交給建構子。
+// 回傳的 T(...) 是一個暫時物件，C++17 保證「複製省略 (copy elision)」：直接蓋在呼叫端的變數上，連 move 都不用。
+
+// 光說不準：自己數！
+// 我們可以替換全域的 operator new / operator delete，每配置一次就把計數器 +1，
+// 然後替每一種建構方式寫死「應該配置幾次」，哪天有人改壞了 (例如把 move 拿掉)，測試就會失敗。
+
+// 程式碼範例：配置次數計數器
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <utility>   // move, forward
+#include <atomic>
+#include <cstdlib>   // malloc, free
+#include <new>       // bad_alloc
+using namespace std;
+
+// 【替換全域的 new / delete】：整個程式所有的 new (包含 string、vector 內部) 都會經過這裡
+atomic<size_t> g_allocs{0};
+void *operator new(size_t size) {
+    g_allocs.fetch_add(1, memory_order_relaxed);
+    if (void *p = malloc(size == 0 ? 1 : size)) return p;
+    throw bad_alloc();
+}
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+// 舊寫法：先複製進參數，再複製進成員
+class old_player {
+public:
+    string name;
+    old_player(string n) { name = n; }
+};
+// 新寫法：下面每一個都是從各章「原封不動」抄過來的建構子 (每章都有自己的 main，沒辦法直接 #include)，
+// 用 namespace 分開同名的 class。改了哪一章的建構子，這裡也要跟著改，測試才量得到
+namespace ch2 {
+class bankaccount {
+private:
+    string owner;
+    int balance;
+public:
+    void init(string n, int amount) {
+        owner = move(n);  // 把參數 n 的內容「搬」進來，不用再複製一份
+        if (amount<0) {
+            balance = 0;  // 防呆：不能有負的開戶金
+            cout<<"Error!"<<endl;
+        }
+        else {
+            balance = amount;
+        }
+    }
+};
+}
+namespace ch4 {
+class player {   // 物件池那一節的 player (第一節的版本建構子一樣，只是多印一行字)
+public:
+    string name;
+    int hp = 100;
+    player(string n) : name(move(n)) {}
+    ~player() {}
+};
+}
+namespace ch5 {
+class character {
+public:
+    string name;
+    int hp;
+    character(string n) {
+        name = move(n);  // 搬進來，不是複製
+        hp = 100;  // 預設血量
+    }
+};
+class warrior : public character {
+public:
+    warrior(string n) : character(move(n)) {}
+};
+class wizard : public character {
+public:
+    wizard(string n) : character(move(n)) {}
+};
+}
+namespace ch6 {
+class Character {
+public:
+    string name;
+    Character(string n) : name(move(n)) {}
+    virtual void attack() {}
+};
+class Warrior : public Character {
+public:
+    Warrior(string n) : Character(move(n)) {}  // 一路搬到父類別，沒有任何一層複製
+};
+class Wizard : public Character {
+public:
+    Wizard(string n) : Character(move(n)) {}
+};
+}
+namespace ch8 {
+template <typename T>
+class Box {
+private:
+    T item;
+public:
+    Box(T i) : item(move(i)) {}
+};
+}
+namespace ch9 {
+class Pet {
+public:
+    string name;
+    Pet(string n) : name(move(n)) {}   // CH9 在這裡還會印「出生了」，不影響配置次數
+};
+}
+using ch4::player;
+using ch8::Box;
+
+// 完美轉發的工廠：回傳的物件直接蓋在呼叫端 (copy elision)
+template <typename T, typename... Args>
+T make(Args&&... args) {
+    return T(forward<Args>(args)...);
+}
+
+// 小小的測試框架：執行 f，檢查它剛好配置了 expected 次
+int failures = 0;
+template <typename F>
+void expect_allocs(const char *label, size_t expected, F f) {
+    size_t before = g_allocs.load();
+    f();
+    size_t got = g_allocs.load() - before;
+    if (got != expected) failures++;
+    cout << (got == expected ? "[PASS] " : "[FAIL] ") << label << ": 配置 " << got << " 次 (預期 " << expected << ")" << endl;
+}
+
+int main() {
+    // 超過 15 個字元，string 一定要去 Heap 配置
+    const string longname = "Arthur, King of the Britons";
+
+    // 測試資料先在外面準備好，計數器只數 lambda 裡那一行
+    string n1 = longname, n2 = longname;
+    vector<int> scores(1000);
+    vector<player> party;
+    party.reserve(3);
+
+    expect_allocs("old_player(左值)       ", 2, [&] { old_player p(longname); });
+    expect_allocs("player(左值)           ", 1, [&] { player p(longname); });
+    expect_allocs("player(move 右值)      ", 0, [&] { player p(move(n1)); });
+    expect_allocs("player(字串常值)       ", 1, [] { player p("Lancelot of the Lake, Knight"); });
+    expect_allocs("CH2 init(左值)         ", 1, [&] { ch2::bankaccount a; a.init(longname, 100); });
+    expect_allocs("CH5 character(左值)    ", 1, [&] { ch5::character c(longname); });
+    expect_allocs("CH5 warrior(左值)      ", 1, [&] { ch5::warrior w(longname); });
+    expect_allocs("CH5 wizard(左值)       ", 1, [&] { ch5::wizard w(longname); });
+    expect_allocs("CH6 Character(左值)    ", 1, [&] { ch6::Character c(longname); });
+    expect_allocs("CH6 Warrior(左值)      ", 1, [&] { ch6::Warrior w(longname); });
+    expect_allocs("CH6 Wizard(左值)       ", 1, [&] { ch6::Wizard w(longname); });
+    expect_allocs("CH9 make_unique<Pet>   ", 2, [&] { auto p = make_unique<ch9::Pet>(longname); });  // 物件本身 + 名字
+    expect_allocs("Box<string>(左值)      ", 1, [&] { Box<string> b(longname); });
+    expect_allocs("Box<vector>(move 右值) ", 0, [&] { Box<vector<int>> b(move(scores)); });
+    expect_allocs("make<player>(左值)     ", 1, [&] { player p = make<player>(longname); });
+    expect_allocs("make<player>(move 右值)", 0, [&] { player p = make<player>(move(n2)); });
+    expect_allocs("make_unique<player>    ", 2, [&] { auto p = make_unique<player>(longname); });  // 物件本身 + 名字
+    expect_allocs("emplace_back(左值)     ", 1, [&] { party.emplace_back(longname); });
+
+    cout << (failures == 0 ? "全部通過" : "有配置次數變多了！") << endl;
+    return failures == 0 ? 0 : 1;
+}
+// 重點筆記：
+// 1. 「傳值 + move」是建構子收參數的標準姿勢：左值複製 1 次，右值 0 次，只要寫一個建構子。
+// 2. 樣板工廠用 Args&& + forward，參數是左值還是右值都原樣交給建構子。
+// 3. 回傳暫時物件 return T(...); 由 C++17 保證複製省略，不會多一次 move 或 copy。
+// 4. 效能不要用猜的：把配置次數寫成測試，改壞了馬上就知道。
+
+
+// 補充 : 大東西的盒子 —— 寫入時才複製 (Copy-on-Write)
+// 上面的 Box<T> 裝 int 沒問題，但如果 T 是一個 1MB 的 vector 或 string：
+// Box 每被複製一次 (傳值、放進 vector、指派給別人)，1MB 的內容就被整份複製一次。
+// 可是大部分的複本從頭到尾都只是「看」(show)，根本沒有要改。
+// 寫入時複製 (Copy-on-Write, COW) 的想法：
+// a. 複製盒子時，不複製內容，只是大家「共用同一份」，旁邊記一個計數器 (跟 CH9 的 shared_ptr 一樣)。
+// b. 讀取 (show / get) 直接看共用的那份，零複製。
+// c. 真的要改的時候，如果發現還有別人在共用，才自己複製一份出來改，不影響別人。
+// 計數器有兩種策略 (policy)：
+// 單執行緒版：普通的 long，最快。
+// 多執行緒版：atomic<long>，不同執行緒各自持有盒子複本時也安全 (代價是每次 +1 / -1 都是原子操作)。
+
+// 程式碼範例：cow_box<T, Policy>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <utility>
+using namespace std;
+
+// 計數策略 1：單執行緒
+struct single_thread {
+    using count_type = long;
+    static void add(count_type &c) { ++c; }
+    static bool release(count_type &c) { return --c == 0; }  // 回傳 true 代表我是最後一個
+    static long get(const count_type &c) { return c; }
+};
+// 計數策略 2：多執行緒 (原子操作)
+struct thread_safe {
+    using count_type = atomic<long>;
+    static void add(count_type &c) { c.fetch_add(1, memory_order_relaxed); }
+    static bool release(count_type &c) { return c.fetch_sub(1, memory_order_acq_rel) == 1; }
+    static long get(const count_type &c) { return c.load(memory_order_acquire); }
+};
+
+template <typename T, typename Policy = single_thread>
+class cow_box {
+private:
+    struct payload {
+        typename Policy::count_type refs;
+        bool unshareable = false;   // edit() 交出過 T& 了：那個參考可能還活著，不能再讓別人共用
+        T item;
+        explicit payload(T i) : refs(1), item(move(i)) {}
+    };
+    payload *p;   // 被 move 走之後是 nullptr，當成「空盒子」(跟 shared_ptr 一樣)
+
+    void release() {
+        if (p != nullptr && Policy::release(p->refs)) delete p;
+    }
+public:
+    explicit cow_box(T i) : p(new payload(move(i))) {}
+    // 複製盒子：不複製內容，計數器 +1
+    // 但如果對方的內容已經被 edit() 借出去過，只能老實複製一份 (不然透過那個 T& 寫入會改到兩個盒子)
+    cow_box(const cow_box &o) : p(o.p) {
+        if (p == nullptr) return;
+        if (p->unshareable) p = new payload(o.p->item);
+        else Policy::add(p->refs);
+    }
+    cow_box(cow_box &&o) noexcept : p(exchange(o.p, nullptr)) {}
+    cow_box &operator=(cow_box o) noexcept {   // copy-and-swap：複製 / 搬移指派都靠它
+        swap(p, o.p);
+        return *this;
+    }
+    ~cow_box() { release(); }
+
+    // 讀取：直接看共用的那一份，零複製 (空盒子讀到的是 T{})
+    const T &get() const {
+        static const T empty{};
+        return p != nullptr ? p->item : empty;
+    }
+    void show() const {
+        if (p == nullptr) cout << "空盒子 (已經被 move 走了)" << endl;
+        else if constexpr (requires(const T &t) { cout << t; }) cout << "盒子裡裝的是: " << p->item << endl;
+        else cout << "盒子裡裝的東西有 " << p->item.size() << " 個元素" << endl;
+    }
+    // 寫入：還有別人在共用的話，先複製一份自己的再改
+    T &edit() {
+        if (p == nullptr) p = new payload(T{});
+        else if (Policy::get(p->refs) != 1) {
+            payload *mine = new payload(p->item);  // 真正複製內容的只有這裡
+            release();
+            p = mine;
+        }
+        p->unshareable = true;   // 呼叫的人手上有 T& 了，之後的複製都要真的複製
+        return p->item;
+    }
+    long use_count() const { return p != nullptr ? Policy::get(p->refs) : 0; }
+};
+
+// CH8 原本的 Box (對照組)：複製盒子 = 複製內容
+template <typename T>
+class Box {
+private:
+    T item;
+public:
+    Box(T i) : item(move(i)) {}
+    const T &get() const { return item; }
+    T &edit() { return item; }
+};
+
+// 扇出 (fan-out)：一份 1MB 的資料發給 1000 個人，其中只有 10 個人要改
+template <typename B>
+void fan_out(const char *label, const B &original, int copies, int writers) {
+    auto t0 = chrono::steady_clock::now();
+    vector<B> boxes;
+    boxes.reserve(copies);
+    for (int i = 0; i < copies; i++) boxes.push_back(original);  // 複製盒子
+    long sum = 0;
+    for (const B &b : boxes) sum += b.get()[0];                    // 每個人都讀
+    for (int i = 0; i < writers; i++) boxes[i].edit()[0] = 'X';    // 少數人寫
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+    cout << label << ": " << ms << " ms (讀到的總和 " << sum << ")" << endl;
+}
+
+int main() {
+    // 1. 用法跟 Box 一樣，讀取不會複製
+    cow_box<string> a(string("Hello"));
+    cow_box<string> b = a;                 // 共用，沒有複製
+    cout << "共用中: " << a.use_count() << " 個盒子" << endl;
+    b.edit() += ", World";                 // b 要改 -> 這時候才複製一份給 b
+    a.show();
+    b.show();
+    cout << "寫入之後: a 的計數 = " << a.use_count() << ", b 的計數 = " << b.use_count() << " (已經各自一份)" << endl;
+
+    // 先拿 edit() 的參考，之後再複製：c 要拿到自己的一份，透過 ref 寫入不能改到 c
+    string &ref = b.edit();
+    cow_box<string> c = b;
+    ref += "!";
+    cout << "b = " << b.get() << ", c = " << c.get() << " (c 不受影響)" << endl;
+
+    // 被 move 走的盒子是空盒子，可以讀、複製、重新寫入，不會碰到 nullptr
+    cow_box<string> d = move(c);
+    cow_box<string> e = c;
+    c.show();
+    cout << "空盒子的計數 = " << e.use_count() << ", 內容長度 = " << e.get().size() << endl;
+    c.edit() = "重新裝東西";
+    c.show();
+
+    // 2. 1MB 的資料發給 1000 個人
+    const int copies = 1000, writers = 10;
+    vector<char> big(1 << 20, 'a');
+    cout << "--- 1MB 資料 x " << copies << " 份, 其中 " << writers << " 份被修改 ---" << endl;
+    fan_out("Box (每次都複製)      ", Box<vector<char>>(big), copies, writers);
+    fan_out("cow_box (單執行緒計數)", cow_box<vector<char>>(big), copies, writers);
+    fan_out("cow_box (原子計數)    ", cow_box<vector<char>, thread_safe>(big), copies, writers);
+    cow_box<vector<char>> shared(big);
+    shared.show();
+    return 0;
+}
+// 重點筆記：
+// 1. COW = 「讀的時候共用，寫的時候才分家」：1000 個複本只有被改的那 10 個真的付出了複製的代價。
+// 2. 計數策略用樣板參數 (Policy) 傳進去：同一份 cow_box 程式碼，單執行緒用 long，多執行緒用 atomic<long>。
+// 3. 讀取回傳 const T&，寫入一定要經過 edit()，這樣盒子才有機會在寫之前「分家」。
+//    edit() 交出去的 T& 可能被留著，所以交出之後這份內容就標成「不能共用」，下次複製一定真的複製。
+// 4. 小東西 (int、double) 不需要 COW，直接複製反而比較快；COW 是給大東西用的。
+// 5. 被 move 走的物件也要是「合法的」：cow_box 搬走之後是空盒子，讀、複製、指派都不會出事。
+
+
+// 補充 : 把物件存起來、傳出去 (二進位序列化 + 零複製讀取)
+// 到目前為止，player、character、bankaccount、Box<T> 都只活在記憶體裡，
+// 想存檔或透過網路傳出去，最直覺的是用 cout << 印成文字 (或 JSON)。
+// 文字的問題：數字要轉成字串、讀回來又要解析字串，資料又大又慢。
+// 二進位格式：
+// 1. 固定長度 (fixed)：int 就是 4 個 bytes，一律用 little-endian 排列 (不管哪種 CPU 寫出來都一樣)。
+// 2. varint：小的數字用少少的 bytes (每 byte 放 7 個位元，最高位元代表「後面還有」)，
+//    負數先做 zigzag (0,-1,1,-2... -> 0,1,2,3...)，-1 才不會變成 10 個 bytes。
+// 3. 字串：先寫長度 (varint)，再寫內容。
+// 每個 class 只要寫一行「欄位表 (schema)」，serialize / deserialize 由樣板自動產生 —— 這就是本章的模具。
+// 4. 零複製 view：不建立物件，直接在 buffer 上讀某一個欄位 (字串回傳 string_view，指向 buffer 本身)。
+//    只想統計「所有玩家的 hp 總和」時，不必把 1000 萬個 string 都建出來。
+
+// 程式碼範例：
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <tuple>
+#include <type_traits>
+#include <stdexcept>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+#include <limits>
+#include <bit>
+using namespace std;
+
+// ---- 欄位表 ----
+enum class enc { fixed, varint };
+template <auto Member, enc E = enc::fixed>
+struct field {
+    static constexpr auto member = Member;
+    static constexpr enc encoding = E;
+};
+template <typename... Fields>
+struct schema {};
+
+// 有 fields 欄位表的型別
+template <typename T>
+concept has_schema = requires { typename T::fields; };
+
+// ---- 各章的類別，每個只多一行欄位表 ----
+class player {       // CH4
+public:
+    string name;
+    int hp = 100;
+    int level = 1;
+    using fields = schema<field<&player::name>, field<&player::hp, enc::varint>, field<&player::level, enc::varint>>;
+};
+class character {    // CH5
+public:
+    string name;
+    int hp = 100;
+    using fields = schema<field<&character::name>, field<&character::hp, enc::varint>>;
+};
+class bankaccount {  // CH2 (private 的欄位一樣可以列進表裡，外面還是改不到)
+private:
+    string owner;
+    int balance = 0;
+public:
+    void init(string n, int amount) {
+        owner = move(n);
+        balance = amount < 0 ? 0 : amount;
+    }
+    int getbalance() const { return balance; }
+    const string &getowner() const { return owner; }
+    using fields = schema<field<&bankaccount::owner>, field<&bankaccount::balance, enc::fixed>>;
+};
+template <typename T>
+class Box {          // 本章
+private:
+    T item;
+public:
+    Box() = default;
+    Box(T i) : item(move(i)) {}
+    const T &get() const { return item; }
+    using fields = schema<field<&Box::item>>;  // T 自己怎麼存，交給 T
+};
+
+// ---- 寫入 ----
+class writer {
+public:
+    vector<uint8_t> buf;
+    template <typename U>
+    void fixed(U v) {                                  // little-endian
+        static_assert(is_arithmetic_v<U>);
+        if constexpr (endian::native == endian::big) {
+            uint8_t tmp[sizeof(U)];
+            memcpy(tmp, &v, sizeof(U));
+            for (size_t i = 0; i < sizeof(U); i++) buf.push_back(tmp[sizeof(U) - 1 - i]);
+        }
+        else {
+            size_t at = buf.size();
+            buf.resize(at + sizeof(U));
+            memcpy(&buf[at], &v, sizeof(U));
+        }
+    }
+    void varint(uint64_t v) {
+        while (v >= 0x80) {
+            buf.push_back(uint8_t(v) | 0x80);
+            v >>= 7;
+        }
+        buf.push_back(uint8_t(v));
+    }
+    template <typename U>
+    void varint_of(U v) {
+        static_assert(is_integral_v<U>, "enc::varint 只能用在整數欄位 (double 會被默默截斷)");
+        if constexpr (is_signed_v<U>) varint((uint64_t(v) << 1) ^ uint64_t(int64_t(v) >> 63));  // zigzag
+        else varint(v);
+    }
+    void bytes(string_view s) {
+        varint(s.size());
+        buf.insert(buf.end(), s.begin(), s.end());
+    }
+};
+
+// ---- 讀取 ----
+class reader {
+private:
+    const uint8_t *p;
+    const uint8_t *end;
+    void need(size_t n) {
+        if ((size_t)(end - p) < n) throw runtime_error("資料不完整");
+    }
+public:
+    reader(const uint8_t *b, const uint8_t *e) : p(b), end(e) {}
+    const uint8_t *pos() const { return p; }
+    bool done() const { return p == end; }
+    template <typename U>
+    U fixed() {
+        need(sizeof(U));
+        U v;
+        if constexpr (endian::native == endian::big) {
+            uint8_t tmp[sizeof(U)];
+            for (size_t i = 0; i < sizeof(U); i++) tmp[i] = p[sizeof(U) - 1 - i];
+            memcpy(&v, tmp, sizeof(U));
+        }
+        else {
+            memcpy(&v, p, sizeof(U));
+        }
+        p += sizeof(U);
+        return v;
+    }
+    uint64_t varint() {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            need(1);
+            uint8_t b = *p++;
+            v |= uint64_t(b & 0x7f) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        throw runtime_error("varint 太長");
+    }
+    // 解出來的數字要放得進欄位的型別：壞掉 (或故意亂造) 的資料不能變成「繞回來」的 hp、level
+    template <typename U>
+    U varint_of() {
+        static_assert(is_integral_v<U>, "enc::varint 只能用在整數欄位 (double 會被默默截斷)");
+        uint64_t v = varint();
+        if constexpr (is_signed_v<U>) {
+            int64_t s = int64_t((v >> 1) ^ (~(v & 1) + 1));   // 反 zigzag
+            if (s < numeric_limits<U>::min() || s > numeric_limits<U>::max()) throw runtime_error("varint 超出欄位範圍");
+            return U(s);
+        }
+        else {
+            if (v > numeric_limits<U>::max()) throw runtime_error("varint 超出欄位範圍");
+            return U(v);
+        }
+    }
+    string_view bytes() {
+        size_t n = varint();
+        need(n);
+        string_view s((const char*)p, n);
+        p += n;
+        return s;
+    }
+};
+
+// ---- 樣板自動產生的 serialize / deserialize ----
+template <typename V, enc E = enc::fixed>
+void write_value(writer &w, const V &v);
+template <typename V, enc E = enc::fixed>
+void read_value(reader &r, V &v);
+
+template <typename T, typename... Fields>
+void write_fields(writer &w, const T &obj, schema<Fields...>) {
+    (write_value<remove_cvref_t<decltype(obj.*Fields::member)>, Fields::encoding>(w, obj.*Fields::member), ...);
+}
+template <typename T, typename... Fields>
+void read_fields(reader &r, T &obj, schema<Fields...>) {
+    (read_value<remove_cvref_t<decltype(obj.*Fields::member)>, Fields::encoding>(r, obj.*Fields::member), ...);
+}
+
+template <typename V, enc E>
+void write_value(writer &w, const V &v) {
+    if constexpr (has_schema<V>) write_fields(w, v, typename V::fields{});  // 巢狀：Box<player>
+    else if constexpr (is_same_v<V, string>) w.bytes(v);
+    else if constexpr (E == enc::varint) w.varint_of(v);
+    else w.fixed(v);
+}
+template <typename V, enc E>
+void read_value(reader &r, V &v) {
+    if constexpr (has_schema<V>) read_fields(r, v, typename V::fields{});
+    else if constexpr (is_same_v<V, string>) v = string(r.bytes());
+    else if constexpr (E == enc::varint) v = r.template varint_of<V>();
+    else v = r.template fixed<V>();
+}
+
+template <has_schema T>
+void serialize(writer &w, const T &obj) { write_value(w, obj); }
+template <has_schema T>
+T deserialize(reader &r) {
+    T obj;
+    read_value(r, obj);
+    return obj;
+}
+
+// ---- 零複製 view：不建立物件，直接讀 buffer ----
+// 跳過一個欄位 (不解碼內容)
+template <typename V, enc E>
+void skip_value(reader &r) {
+    if constexpr (has_schema<V>) {
+        [&]<typename... Fields>(schema<Fields...>) {
+            (skip_value<remove_cvref_t<decltype(declval<V&>().*Fields::member)>, Fields::encoding>(r), ...);
+        }(typename V::fields{});
+    }
+    else if constexpr (is_same_v<V, string>) r.bytes();
+    else if constexpr (E == enc::varint) r.template varint_of<V>();   // 跳過也要檢查範圍 (view 和 deserialize 看法要一致)
+    else r.template fixed<V>();
+}
+
+// 兩個成員指標是不是同一個欄位 (型別不同就一定不是，不能直接用 == 比)
+template <auto A, auto B>
+constexpr bool same_member() {
+    if constexpr (is_same_v<decltype(A), decltype(B)>) return A == B;
+    else return false;
+}
+
+template <has_schema T>
+class view {
+private:
+    const uint8_t *begin;
+    const uint8_t *end;
+public:
+    view(const uint8_t *b, const uint8_t *e) : begin(b), end(e) {}
+    // v.get<&player::hp>()：跳過前面的欄位，只解碼這一個；字串回傳 string_view (指向 buffer)
+    template <auto Member>
+    auto get() const {
+        reader r(begin, end);
+        return find<Member>(r, typename T::fields{});
+    }
+    // 這一筆資料佔幾個 bytes (用來走到下一筆)
+    size_t size() const {
+        reader r(begin, end);
+        skip_value<T, enc::fixed>(r);
+        return r.pos() - begin;
+    }
+private:
+    template <auto Member, typename F, typename... Rest>
+    static auto find(reader &r, schema<F, Rest...>) {
+        using V = remove_cvref_t<decltype(declval<T&>().*F::member)>;
+        if constexpr (same_member<F::member, Member>()) {
+            if constexpr (has_schema<V>) {
+                const uint8_t *start = r.pos();
+                skip_value<V, F::encoding>(r);
+                return view<V>(start, r.pos());
+            }
+            else if constexpr (is_same_v<V, string>) return r.bytes();
+            else if constexpr (F::encoding == enc::varint) return r.template varint_of<V>();
+            else return r.template fixed<V>();
+        }
+        else {
+            static_assert(sizeof...(Rest) > 0, "這個類別的欄位表裡沒有這個欄位");
+            skip_value<V, F::encoding>(r);
+            return find<Member>(r, schema<Rest...>{});
+        }
+    }
+};
+
+// 一個 buffer 裡連續放很多筆：用 for 一筆一筆走過去
+template <has_schema T>
+class records {
+private:
+    const uint8_t *b;
+    const uint8_t *e;
+public:
+    records(const vector<uint8_t> &buf) : b(buf.data()), e(buf.data() + buf.size()) {}
+    struct iterator {
+        const uint8_t *p, *e;
+        view<T> operator*() const { return view<T>(p, e); }
+        iterator &operator++() {
+            p += view<T>(p, e).size();
+            return *this;
+        }
+        bool operator!=(const iterator &o) const { return p != o.p; }
+    };
+    iterator begin() const { return {b, e}; }
+    iterator end() const { return {e, e}; }
+};
+
+// ---- 對照組：文字 和 JSON ----
+void to_text(ostream &os, const player &p) { os << p.name << ' ' << p.hp << ' ' << p.level << '\n'; }
+bool from_text(istream &is, player &p) { return bool(is >> p.name >> p.hp >> p.level); }
+
+void to_json(string &out, const player &p) {
+    out += "{\"name\":\"";
+    out += p.name;  // 範例的名字沒有引號或反斜線，省略跳脫 (escape)
+    out += "\",\"hp\":";
+    out += to_string(p.hp);
+    out += ",\"level\":";
+    out += to_string(p.level);
+    out += "}\n";
+}
+// 極簡的 JSON 讀取：只認得上面寫出來的格式
+bool from_json(string_view &in, player &p) {
+    auto value = [&](string_view key) {
+        size_t k = in.find(key);
+        if (k == string_view::npos) throw runtime_error("JSON 格式錯誤");
+        in.remove_prefix(k + key.size());
+    };
+    if (in.empty()) return false;
+    value("\"name\":\"");
+    size_t q = in.find('"');
+    p.name = string(in.substr(0, q));
+    in.remove_prefix(q + 1);
+    value("\"hp\":");
+    p.hp = stoi(string(in.substr(0, in.find(','))));
+    value("\"level\":");
+    p.level = stoi(string(in.substr(0, in.find('}'))));
+    in.remove_prefix(in.find('\n') + 1);
+    return true;
+}
+
+template <typename F>
+double timed(F f) {
+    auto t0 = chrono::steady_clock::now();
+    f();
+    return chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char **argv) {
+    // 1. 每一種類別都可以存、可以讀回來
+    {
+        writer w;
+        bankaccount acct;
+        acct.init("Justin", 1000);
+        serialize(w, player{"Arthur", 87, 12});
+        serialize(w, character{"Merlin", -3});
+        serialize(w, acct);
+        serialize(w, Box<player>(player{"Lancelot", 100, 40}));
+        serialize(w, Box<string>("寶劍"));
+        cout << "5 個物件一共 " << w.buf.size() << " bytes，開頭: ";
+        for (int i = 0; i < 9; i++) cout << hex << (int)w.buf[i] << ' ';
+        cout << dec << endl;
+
+        reader r(w.buf.data(), w.buf.data() + w.buf.size());
+        player p = deserialize<player>(r);
+        character c = deserialize<character>(r);
+        bankaccount b = deserialize<bankaccount>(r);
+        Box<player> bp = deserialize<Box<player>>(r);
+        Box<string> bs = deserialize<Box<string>>(r);
+        cout << p.name << " hp=" << p.hp << " lv=" << p.level << " | " << c.name << " hp=" << c.hp << " | "
+             << b.getowner() << " $" << b.getbalance() << " | 盒子: " << bp.get().name << ", " << bs.get() << endl;
+
+        // view：不建立物件，直接讀欄位 (巢狀的 Box<player> 也可以往裡面看)
+        view<player> vp(w.buf.data(), w.buf.data() + w.buf.size());
+        string_view name = vp.get<&player::name>();
+        cout << "view 讀到: " << name << " lv=" << vp.get<&player::level>() << "，這一筆 " << vp.size() << " bytes" << endl;
+
+        try {
+            reader broken(w.buf.data(), w.buf.data() + 3);   // 資料被截斷
+            deserialize<player>(broken);
+        }
+        catch (const exception &e) {
+            cout << "讀取截斷的資料: " << e.what() << endl;
+        }
+        try {
+            writer evil;                        // 手工造一筆 hp 大到 int 放不下的資料
+            evil.bytes("Mordred");
+            evil.varint(uint64_t(1) << 40);
+            evil.varint(2);
+            reader r2(evil.buf.data(), evil.buf.data() + evil.buf.size());
+            deserialize<player>(r2);
+        }
+        catch (const exception &e) {
+            cout << "讀取超出範圍的 hp: " << e.what() << endl;
+        }
+    }
+
+    // 2. 1000 萬個玩家：二進位 vs 文字 vs JSON
+    size_t n = argc > 1 ? stoul(argv[1]) : 10000000;
+    vector<player> party(n);
+    for (size_t i = 0; i < n; i++) party[i] = {"hero" + to_string(i % 100000), int(i % 1000), int(i % 60) + 1};
+    long expect_hp = 0;
+    for (auto &p : party) expect_hp += p.hp;
+
+    writer bin;
+    string text, json;
+    double enc_bin = timed([&] {
+        bin.buf.reserve(n * 12);
+        for (auto &p : party) serialize(bin, p);
+    });
+    double enc_text = timed([&] {
+        ostringstream os;
+        for (auto &p : party) to_text(os, p);
+        text = move(os).str();
+    });
+    double enc_json = timed([&] {
+        json.reserve(n * 40);
+        for (auto &p : party) to_json(json, p);
+    });
+    party.clear();
+    party.shrink_to_fit();
+
+    long hp_bin = 0, hp_text = 0, hp_json = 0, hp_view = 0;
+    double dec_bin = timed([&] {
+        vector<player> out;
+        out.reserve(n);
+        reader r(bin.buf.data(), bin.buf.data() + bin.buf.size());
+        while (!r.done()) out.push_back(deserialize<player>(r));
+        for (auto &p : out) hp_bin += p.hp;
+    });
+    double dec_text = timed([&] {
+        vector<player> out;
+        out.reserve(n);
+        istringstream is(text);
+        player p;
+        while (from_text(is, p)) out.push_back(move(p));
+        for (auto &q : out) hp_text += q.hp;
+    });
+    double dec_json = timed([&] {
+        vector<player> out;
+        out.reserve(n);
+        string_view in = json;
+        player p;
+        while (from_json(in, p)) out.push_back(move(p));
+        for (auto &q : out) hp_json += q.hp;
+    });
+    double view_bin = timed([&] {
+        for (view<player> v : records<player>(bin.buf)) hp_view += v.get<&player::hp>();
+    });
+
+    cout << n << " 個玩家            大小(MB)    寫入(秒)    讀回(秒)" << endl;
+    cout << "  二進位            " << bin.buf.size() / 1e6 << "\t" << enc_bin << "\t" << dec_bin << endl;
+    cout << "  文字 (<< / >>)    " << text.size() / 1e6 << "\t" << enc_text << "\t" << dec_text << endl;
+    cout << "  JSON             " << json.size() / 1e6 << "\t" << enc_json << "\t" << dec_json << endl;
+    cout << "  二進位 view 只讀 hp (不建立物件): " << view_bin << " 秒" << endl;
+    bool ok = hp_bin == expect_hp && hp_text == expect_hp && hp_json == expect_hp && hp_view == expect_hp;
+    cout << "hp 總和 " << expect_hp << (ok ? " (四種讀法一致)" : " (不一致!)") << endl;
+    return ok ? 0 : 1;
+}
+// 重點筆記：
+// 1. 每個類別只寫一行欄位表，serialize / deserialize 用樣板 + fold expression 自動產生，新增欄位不會忘了存。
+// 2. 一律 little-endian、varint 存小數字、zigzag 存負數：檔案小，而且換一台電腦讀也一樣。
+// 3. view 直接在 buffer 上讀欄位，字串是 string_view，不配置記憶體；只要其中幾個欄位時特別划算。
+// 4. 讀取外部資料一定要檢查長度，資料被截斷就 throw，不要讀到 buffer 外面去。
+//    數值也一樣：varint 解出來放不進欄位的型別 (int) 就 throw，不要默默截斷；varint 欄位只能是整數，編譯期就擋。
@@ -30,7 +30,7 @@ using namespace std;
 class Pet {
 public:
     string name;
-    Pet(string n) : name(n) {
+    Pet(string n) : name(move(n)) {
         cout<< name << " 出生了" << endl;
     }
     ~Pet() {
@@ -120,3 +120,514 @@ int main() {
 // unique_ptr: 獨佔所有權，不能複製，離開 Scope 自動刪除。這應該是你的預設選擇。
 // shared_ptr: 共享所有權，靠計數器決定生死。
 // make_unique / make_shared: 用這兩個函式來生出指標，不要直接用 new。
+
+
+// 補充 : 把寵物交給別的執行緒 (無鎖佇列 Lock-free Queue)
+// 上面的範例中，所有權只是在同一個執行緒裡從 p1 搬到 p2。
+// 真實的伺服器常常是「生產者 (producer) 執行緒建立物件 -> 交給消費者 (consumer) 執行緒處理」，
+// 最直覺的寫法是 mutex + std::queue，但幾十條執行緒搶同一把鎖時，大家都在排隊，吞吐量就上不去了。
+// 無鎖佇列用 atomic 操作 (compare_exchange、exchange) 取代鎖：
+// 1. 有界 MPMC 環狀佇列 (Vyukov 的設計)：多生產者、多消費者，容量固定。
+//    每一格都有自己的序號 (sequence)，生產者 / 消費者只要搶「位置」，搶到了就只碰自己那一格。
+//    每一格對齊快取線 (64 bytes)，相鄰兩格被不同核心寫入時不會互相干擾 (避免 false sharing)。
+// 2. 無界 MPSC 佇列：多生產者、單一消費者，用鏈結串列，不會滿。
+//    生產者只做一次 exchange 就把節點接上去，消費者自己一個人往後走。
+// unique_ptr<Pet> 不能複製只能 move —— 這兩個佇列都只用 move，所以所有權交接得乾乾淨淨。
+
+// 記憶體回收筆記：無鎖的資料結構最麻煩的是「什麼時候可以 delete 節點」
+// (別的執行緒可能還拿著指標在讀)，一般要用 hazard pointer 或 epoch 回收。
+// 但這兩個設計剛好都不需要：
+// MPMC 的格子是一開始就配好的陣列，永遠不刪；
+// MPSC 的節點只有唯一的消費者會讀和刪，生產者接上節點之後就再也不碰它了。
+// (讀者很多、需要真正延後回收的情況，請看下一個補充的 epoch 回收。)
+
+// 程式碼範例：
+#include <iostream>
+#include <string>
+#include <vector>
+#include <queue>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <optional>
+#include <new>
+#include <utility>
+using namespace std;
+class Pet {
+public:
+    string name;
+    long id;
+    Pet(string n, long i) : name(move(n)), id(i) {}
+};
+
+// 1. 有界 MPMC 環狀佇列
+template <typename T>
+class mpmc_queue {
+private:
+    struct alignas(64) cell {
+        atomic<size_t> seq;
+        alignas(T) unsigned char storage[sizeof(T)];  // 不要求 T 有預設建構子
+        T *item() { return reinterpret_cast<T*>(storage); }
+    };
+    size_t mask;
+    unique_ptr<cell[]> cells;
+    alignas(64) atomic<size_t> enqueue_pos{0};  // 生產者搶這個
+    alignas(64) atomic<size_t> dequeue_pos{0};  // 消費者搶這個 (分開放，兩邊不會互相干擾)
+public:
+    explicit mpmc_queue(size_t capacity_pow2) : mask(capacity_pow2 - 1), cells(new cell[capacity_pow2]) {
+        for (size_t i = 0; i < capacity_pow2; i++) cells[i].seq.store(i, memory_order_relaxed);
+    }
+    ~mpmc_queue() {
+        // 解構時已經沒有別的執行緒在用了，把還沒被拿走的東西解構掉
+        size_t end = enqueue_pos.load();
+        for (size_t pos = dequeue_pos.load(); pos != end; pos++) cells[pos & mask].item()->~T();
+    }
+    // 佇列滿了回傳 false (東西還在 v 裡，沒有被搬走)
+    bool try_push(T &v) {
+        size_t pos = enqueue_pos.load(memory_order_relaxed);
+        while (true) {
+            cell &c = cells[pos & mask];
+            size_t seq = c.seq.load(memory_order_acquire);
+            long diff = (long)seq - (long)pos;
+            if (diff == 0) {                  // 這一格空著，而且輪到 pos 這一號
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                    new (c.storage) T(move(v));
+                    c.seq.store(pos + 1, memory_order_release);  // 告訴消費者：可以拿了
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                return false;                 // 繞了一圈還沒被拿走：滿了
+            }
+            else {
+                pos = enqueue_pos.load(memory_order_relaxed);  // 被別人搶先了，重來
+            }
+        }
+    }
+    bool try_pop(T &out) {
+        size_t pos = dequeue_pos.load(memory_order_relaxed);
+        while (true) {
+            cell &c = cells[pos & mask];
+            size_t seq = c.seq.load(memory_order_acquire);
+            long diff = (long)seq - (long)(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                    out = move(*c.item());
+                    c.item()->~T();
+                    c.seq.store(pos + mask + 1, memory_order_release);  // 這一格留給下一圈的生產者
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                return false;                 // 空的
+            }
+            else {
+                pos = dequeue_pos.load(memory_order_relaxed);
+            }
+        }
+    }
+};
+
+// 2. 無界 MPSC 佇列 (只能有一個消費者)
+template <typename T>
+class mpsc_queue {
+private:
+    struct node {
+        atomic<node*> next{nullptr};
+        optional<T> value;
+    };
+    alignas(64) atomic<node*> head;  // 生產者從這裡接上新節點
+    alignas(64) node *tail;          // 消費者從這裡往後讀 (只有它自己碰)
+public:
+    mpsc_queue() {
+        node *stub = new node;       // 假節點：讓串列永遠不是空的，程式碼就不用處理特例
+        head.store(stub);
+        tail = stub;
+    }
+    ~mpsc_queue() {
+        while (tail != nullptr) {
+            node *n = tail->next.load();
+            delete tail;
+            tail = n;
+        }
+    }
+    void push(T v) {
+        node *n = new node;
+        n->value.emplace(move(v));
+        node *prev = head.exchange(n, memory_order_acq_rel);  // 一個原子操作就搶到「最後一個」的位置
+        prev->next.store(n, memory_order_release);            // 再把前一個接過來
+    }
+    // 只能由唯一的消費者呼叫
+    bool try_pop(T &out) {
+        node *next = tail->next.load(memory_order_acquire);
+        if (next == nullptr) return false;
+        out = move(*next->value);
+        next->value.reset();
+        delete tail;                 // 舊的假節點可以安心刪掉：生產者不會再碰它
+        tail = next;                 // next 變成新的假節點
+        return true;
+    }
+};
+
+// 對照組：mutex + std::queue
+template <typename T>
+class locked_queue {
+private:
+    mutex mu;
+    queue<T> q;
+public:
+    bool try_push(T &v) {
+        lock_guard<mutex> lk(mu);
+        q.push(move(v));
+        return true;
+    }
+    bool try_pop(T &out) {
+        lock_guard<mutex> lk(mu);
+        if (q.empty()) return false;
+        out = move(q.front());
+        q.pop();
+        return true;
+    }
+};
+// 讓三種佇列的介面一樣，方便寫同一個測試
+template <typename T>
+struct mpsc_adapter {
+    mpsc_queue<T> q;
+    bool try_push(T &v) {
+        q.push(move(v));
+        return true;
+    }
+    bool try_pop(T &out) { return q.try_pop(out); }
+};
+
+// 生產者建立寵物 -> 佇列 -> 消費者接手 (最後由消費者的 unique_ptr 負責刪除)
+// 回傳每秒交接幾百萬隻，順便檢查每一隻都剛好被收到一次
+template <typename Q>
+double handoff(Q &q, int producers, int consumers, long total, bool &ok) {
+    atomic<long> consumed{0}, id_sum{0};
+    long per = total / producers;
+    total = per * producers;
+    auto t0 = chrono::steady_clock::now();
+    vector<thread> ts;
+    for (int p = 0; p < producers; p++) {
+        ts.emplace_back([&, p] {
+            for (long i = 0; i < per; i++) {
+                auto pet = make_unique<Pet>("小黑", p * per + i);
+                while (!q.try_push(pet)) this_thread::yield();  // 滿了就讓一下
+            }
+        });
+    }
+    for (int c = 0; c < consumers; c++) {
+        ts.emplace_back([&] {
+            unique_ptr<Pet> pet;
+            long local = 0;
+            while (consumed.load(memory_order_relaxed) < total) {
+                if (q.try_pop(pet)) {
+                    local += pet->id;
+                    consumed.fetch_add(1, memory_order_relaxed);
+                }
+                else {
+                    this_thread::yield();
+                }
+            }
+            id_sum += local;
+        });
+    }
+    for (auto &t : ts) t.join();
+    double sec = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    ok = ok && id_sum == total * (total - 1) / 2;
+    return total / sec / 1e6;
+}
+
+int main(int argc, char **argv) {
+    // 用法: ./a.out [最多幾條生產者/消費者執行緒]，預設一路測到 64
+    int max_threads = argc > 1 ? stoi(argv[1]) : 64;
+    const long total = 400000;
+    bool ok = true;
+
+    // 先示範所有權交接
+    {
+        mpmc_queue<unique_ptr<Pet>> q(8);
+        auto p1 = make_unique<Pet>("小黑", 1);
+        q.try_push(p1);
+        if (p1 == nullptr) cout << "p1 手上已經空了 (小黑在佇列裡)" << endl;
+        unique_ptr<Pet> p2;
+        thread consumer([&] {
+            while (!q.try_pop(p2)) this_thread::yield();
+        });
+        consumer.join();
+        cout << "另一條執行緒接手了 " << p2->name << endl;
+    }
+
+    cout << "生產者x消費者 | mutex+queue | MPMC 環狀 | MPSC (1 個消費者)  (單位: 百萬隻/秒)" << endl;
+    for (int n = 1; n <= max_threads; n *= 2) {
+        locked_queue<unique_ptr<Pet>> lq;
+        mpmc_queue<unique_ptr<Pet>> rq(1 << 16);
+        mpsc_adapter<unique_ptr<Pet>> sq;
+        double a = handoff(lq, n, n, total, ok);
+        double b = handoff(rq, n, n, total, ok);
+        double c = handoff(sq, n, 1, total, ok);
+        cout << n << " x " << n << "\t\t" << a << "\t\t" << b << "\t\t" << c << endl;
+    }
+    cout << (ok ? "每一隻寵物都剛好被接手一次" : "有寵物不見或重複了!") << endl;
+    return ok ? 0 : 1;
+}
+// 重點筆記：
+// 1. 無鎖佇列裡放 unique_ptr：所有權跟著指標一起被 move 到另一條執行緒，不用 shared_ptr 的計數器。
+// 2. 生產者和消費者的「位置」分開放在不同的快取線，每一格也各自對齊，避免 false sharing。
+// 3. 有界佇列滿了會回傳 false，呼叫端自己決定要等、要丟、還是要擋住上游 (背壓 back-pressure)。
+// 4. 核心數比執行緒少的時候，忙等 (spin) 要記得 yield，不然搶不到 CPU 的那一方會拖垮大家。
+
+
+// 補充 : 很多人一起讀的貼圖 (Epoch 回收，代替 shared_ptr 計數)
+// 前面說「100 隻怪物共用同一張貼圖」適合用 shared_ptr。
+// 但如果有很多條執行緒，每次讀貼圖都先複製一份 shared_ptr，
+// 每次複製 / 解構都要對「同一個計數器」做 atomic 加減，
+// 這個計數器所在的快取線會在各個核心之間搬來搬去 (cache line bouncing)。讀的人越多，大家越慢。
+// 很少改、一直在讀的資料 (read-mostly)，可以改用 RCU / epoch 回收的做法：
+// 1. 讀者：進入一個「epoch」(只寫自己那一格，不碰共用的計數器)，拿到裸指標 const T* 直接讀。
+// 2. 寫者：做一份新版本，用一個 atomic 指標換上去 (publish)。舊版本先不刪，丟進「待回收」清單。
+// 3. 等到所有讀者都離開了舊的 epoch (寬限期 grace period 過了)，才真正 delete 舊版本。
+// 代價：讀者拿到的指標只在 guard 還活著的期間有效，不能存起來帶走 (要帶走請複製資料或改用 shared_ptr)。
+
+// 程式碼範例：
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <deque>
+#include <stdexcept>
+#include <cstdint>
+using namespace std;
+
+// epoch 網域：記住「現在是第幾個 epoch」以及「每個讀者正在哪個 epoch」
+class epoch_domain {
+public:
+    static const int max_readers = 128;
+private:
+    struct alignas(64) reader_slot {      // 每個讀者自己一條快取線，不會互相干擾
+        atomic<uint64_t> active{0};      // 0 = 沒有在讀
+        atomic<bool> used{false};
+    };
+    struct retired {
+        uint64_t epoch;
+        function<void()> free;
+    };
+    alignas(64) atomic<uint64_t> global_epoch{1};
+    reader_slot slots[max_readers];
+    mutex retire_mu;
+    vector<retired> retire_list;
+
+    // 每個網域一個編號：執行緒用 (編號, 格子) 記住自己在「哪個網域」領了哪一格
+    // (只用位址當 key 不夠：網域被刪掉之後，新的網域可能剛好蓋在同一個位址)
+    static inline atomic<uint64_t> next_id{1};
+    const uint64_t id = next_id.fetch_add(1);
+
+    // 每條執行緒第一次在某個網域讀的時候，在「那個網域」領一格，執行緒結束時還回去
+    // 規則：網域要活得比所有用過它的讀者執行緒久
+    struct thread_slot {
+        epoch_domain *dom;
+        uint64_t dom_id;
+        int index;
+        int depth = 0;                   // 允許 guard 巢狀
+    };
+    struct thread_slots {
+        deque<thread_slot> list;         // deque：加新的網域時，guard 手上的參考不會失效
+        ~thread_slots() {
+            for (auto &s : list) s.dom->slots[s.index].used.store(false, memory_order_release);
+        }
+    };
+    thread_slot &my_slot() {
+        static thread_local thread_slots mine;
+        for (auto &s : mine.list)
+            if (s.dom_id == id) return s;
+        for (int i = 0; i < max_readers; i++) {
+            bool expected = false;
+            if (slots[i].used.compare_exchange_strong(expected, true)) {
+                mine.list.push_back({this, id, i});
+                return mine.list.back();
+            }
+        }
+        throw runtime_error("讀者執行緒太多了");
+    }
+public:
+    ~epoch_domain() {
+        for (auto &r : retire_list) r.free();
+    }
+    // 讀者用：建立時進入 epoch，解構時離開
+    class guard {
+    private:
+        epoch_domain &dom;
+        thread_slot &ts;
+    public:
+        explicit guard(epoch_domain &d) : dom(d), ts(d.my_slot()) {
+            if (ts.depth++ == 0) {
+                // seq_cst：保證「宣告自己在讀」一定排在「讀指標」前面，寫者掃描時看得到
+                dom.slots[ts.index].active.store(dom.global_epoch.load(), memory_order_seq_cst);
+            }
+        }
+        ~guard() {
+            if (--ts.depth == 0) dom.slots[ts.index].active.store(0, memory_order_release);
+        }
+        guard(const guard&) = delete;
+        guard &operator=(const guard&) = delete;
+    };
+    // 寫者用：舊物件已經從指標上拿掉了，交給網域延後刪除
+    template <typename T>
+    void retire(const T *old) {
+        if (old == nullptr) return;
+        // 換指標之後才推進 epoch：之後才進來的讀者一定看到新版本
+        uint64_t e = global_epoch.fetch_add(1, memory_order_seq_cst) + 1;
+        lock_guard<mutex> lk(retire_mu);
+        retire_list.push_back({e, [old] { delete old; }});
+    }
+    // 把「所有讀者都已經離開」的舊版本真正刪掉，回傳刪了幾個
+    size_t reclaim() {
+        uint64_t oldest = UINT64_MAX;
+        for (auto &s : slots) {
+            uint64_t a = s.active.load(memory_order_seq_cst);
+            if (a != 0 && a < oldest) oldest = a;
+        }
+        vector<retired> ready;
+        {
+            lock_guard<mutex> lk(retire_mu);
+            size_t keep = 0;
+            for (auto &r : retire_list) {
+                if (r.epoch <= oldest) ready.push_back(move(r));
+                else retire_list[keep++] = move(r);
+            }
+            retire_list.resize(keep);
+        }
+        for (auto &r : ready) r.free();  // 在鎖外面刪，不要讓解構子拖住別人
+        return ready.size();
+    }
+    size_t pending() {
+        lock_guard<mutex> lk(retire_mu);
+        return retire_list.size();
+    }
+};
+
+// 發佈用的指標：讀者拿 const T*，寫者換新版本
+template <typename T>
+class rcu_ptr {
+private:
+    atomic<const T*> cur;
+    epoch_domain &dom;
+public:
+    rcu_ptr(epoch_domain &d, unique_ptr<T> first) : cur(first.release()), dom(d) {}
+    ~rcu_ptr() { delete cur.load(); }
+    // 只能在 guard 的範圍內呼叫，拿到的指標也只能在 guard 的範圍內使用
+    const T *read(const epoch_domain::guard&) const { return cur.load(memory_order_seq_cst); }
+    void publish(unique_ptr<T> next) {
+        const T *old = cur.exchange(next.release(), memory_order_seq_cst);
+        dom.retire(old);
+        dom.reclaim();
+    }
+};
+
+// 共用的貼圖 (4 KB 的像素)
+struct texture {
+    int version;
+    vector<uint32_t> pixels;
+    explicit texture(int v) : version(v), pixels(1024, (uint32_t)v) {}
+};
+
+epoch_domain rcu_domain;
+
+// readers 條讀者執行緒一直讀，同時 (如果 update 為真) 一條寫者執行緒每 1ms 換一張新貼圖
+// read_once(i) 讀一次貼圖，回傳讀到的像素；回傳每秒總共讀了幾百萬次
+double read_bench(int readers, bool update, const function<uint32_t(int)> &read_once,
+                  const function<void(int)> &write_once) {
+    atomic<bool> stop{false};
+    atomic<long> total{0};
+    atomic<uint64_t> sink{0};
+    vector<thread> ts;
+    for (int r = 0; r < readers; r++) {
+        ts.emplace_back([&, r] {
+            long n = 0;
+            uint32_t acc = 0;
+            while (!stop.load(memory_order_relaxed)) {
+                for (int k = 0; k < 256; k++) acc += read_once(r + k);
+                n += 256;
+            }
+            total += n;
+            sink += acc;
+        });
+    }
+    thread writer;
+    if (update) {
+        writer = thread([&] {
+            for (int v = 2; !stop.load(); v++) {
+                write_once(v);
+                this_thread::sleep_for(chrono::milliseconds(1));
+            }
+        });
+    }
+    const double seconds = 0.2;
+    this_thread::sleep_for(chrono::duration<double>(seconds));
+    stop = true;
+    for (auto &t : ts) t.join();
+    if (writer.joinable()) writer.join();
+    return total / seconds / 1e6;
+}
+
+int main(int argc, char **argv) {
+    // 用法: ./a.out [最多幾條讀者執行緒]，預設一路測到 64
+    int max_readers = argc > 1 ? stoi(argv[1]) : 64;
+
+    // 先看一次寬限期：讀者還拿著舊版本時，舊版本不會被刪
+    {
+        rcu_ptr<texture> tex(rcu_domain, make_unique<texture>(1));
+        {
+            epoch_domain::guard g(rcu_domain);
+            const texture *t = tex.read(g);
+            thread([&] { tex.publish(make_unique<texture>(2)); }).join();
+            cout << "換新版本之後，讀者手上的仍然是第 " << t->version << " 版，待回收 " << rcu_domain.pending() << " 個" << endl;
+        }
+        rcu_domain.reclaim();
+        epoch_domain::guard g(rcu_domain);
+        cout << "讀者離開之後：待回收 " << rcu_domain.pending() << " 個，現在讀到第 " << tex.read(g)->version << " 版" << endl;
+    }
+
+    shared_ptr<const texture> plain = make_shared<texture>(1);                   // 前面範例的做法 (不更新)
+    atomic<shared_ptr<const texture>> shared_atomic{make_shared<texture>(1)};    // C++20 可以安全地換版本
+    rcu_ptr<texture> tex(rcu_domain, make_unique<texture>(1));
+
+    auto read_plain = [&](int i) {
+        shared_ptr<const texture> copy = plain;       // 每隻怪物都複製一份 shared_ptr -> 計數器 +1 / -1
+        return copy->pixels[i & 1023];
+    };
+    auto read_atomic = [&](int i) {
+        shared_ptr<const texture> copy = shared_atomic.load();
+        return copy->pixels[i & 1023];
+    };
+    auto read_rcu = [&](int i) {
+        epoch_domain::guard g(rcu_domain);             // 只寫自己的那一格
+        return tex.read(g)->pixels[i & 1023];
+    };
+    auto write_atomic = [&](int v) { shared_atomic.store(make_shared<texture>(v)); };
+    auto write_rcu = [&](int v) { tex.publish(make_unique<texture>(v)); };
+    auto no_write = [](int) {};
+
+    cout << "讀者數 | shared_ptr 複製 (不更新) | atomic<shared_ptr> | epoch/RCU  (單位: 百萬次讀取/秒)" << endl;
+    for (int n = 1; n <= max_readers; n *= 2) {
+        double a = read_bench(n, false, read_plain, no_write);
+        double b = read_bench(n, true, read_atomic, write_atomic);
+        double c = read_bench(n, true, read_rcu, write_rcu);
+        cout << n << "\t" << a << "\t\t\t\t" << b << "\t\t\t" << c << endl;
+    }
+    rcu_domain.reclaim();
+    cout << "結束時待回收: " << rcu_domain.pending() << " 個" << endl;
+    return 0;
+}
+// 重點筆記：
+// 1. shared_ptr 複製一次 = 對共用計數器做一次 atomic 加減，讀的人一多，那條快取線就變成熱點。
+// 2. epoch 讀者只寫「自己那一格」，讀多少次都不會跟別的讀者搶同一條快取線。
+// 3. 寫者換版本後，舊版本要等所有讀者都離開舊 epoch 才能 delete (寬限期)。
+// 4. guard 拿到的裸指標只能在 guard 範圍內使用；要長期持有，還是乖乖用 shared_ptr。